@@ -5,6 +5,7 @@ Rectangle {
     id: root
 
     property string text: ""
+    property int count: -1
     property bool selected: false
 
     signal clicked()
@@ -31,7 +32,7 @@ Rectangle {
 
     Label {
         id: label
-        text: root.text
+        text: root.count >= 0 ? root.text + "  " + root.count : root.text
         anchors.centerIn: parent
         font.weight: root.selected ? Font.Medium : Font.Normal
     }
@@ -8,7 +8,9 @@ Item {
 
     property int promptId: 0
     property string title: ""
-    property string content: ""
+    property string preview: ""
+    // Set while searching: an excerpt around the match, styled with the matches in bold
+    property string snippet: ""
     property string folderName: ""
     property date updatedAt: new Date()
 
@@ -20,7 +22,6 @@ Item {
     signal deleteClicked
     signal duplicateClicked
     signal fillPlaceholdersClicked
-    signal fillPlaceholdersWithContentClicked(string content)
 
     height: 64
     
@@ -39,7 +40,7 @@ Item {
         acceptedButtons: Qt.LeftButton
         onClicked: {
             // Always go to placeholder filling when clicking a prompt
-            root.fillPlaceholdersWithContentClicked(root.content);
+            root.fillPlaceholdersClicked();
         }
     }
 
@@ -71,10 +72,12 @@ Item {
                 }
             }
 
-            // Content preview and date
+            // Content preview and date; while searching, the matching part of the body
             Label {
                 Layout.fillWidth: true
-                text: root.content + " • " + Qt.formatDateTime(root.updatedAt, "MMM d")
+                textFormat: root.snippet.length > 0 ? Text.StyledText : Text.PlainText
+                text: (root.snippet.length > 0 ? root.snippet : root.preview)
+                      + " • " + Qt.formatDateTime(root.updatedAt, "MMM d")
                 elide: Text.ElideRight
                 maximumLineCount: 1
             }
@@ -116,7 +119,7 @@ Item {
                     id: contextMenu
                     MenuItem {
                         text: "Fill Placeholders"
-                        onTriggered: root.fillPlaceholdersWithContentClicked(root.content)
+                        onTriggered: root.fillPlaceholdersClicked()
                     }
                     MenuItem {
                         text: "Duplicate"
@@ -7,6 +7,7 @@ Item {
 
     property alias text: textField.text
     property alias placeholderText: textField.placeholderText
+    property alias ranked: rankButton.checked
     height: 32
 
     
@@ -27,6 +28,16 @@ Item {
             selectByMouse: true
         }
 
+        Button {
+            id: rankButton
+            text: "Best match"
+            visible: textField.text.length > 0
+            flat: true
+            checkable: true
+            ToolTip.visible: hovered
+            ToolTip.text: "Order results by relevance"
+        }
+
         Button {
             text: "✕"
             visible: textField.text.length > 0
@@ -46,6 +46,17 @@ Page {
             placeholderText: "Search prompts..."
             text: promptListViewModel.searchText
             onTextChanged: promptListViewModel.searchText = text
+            ranked: promptListViewModel.rankedSearch
+            onRankedChanged: promptListViewModel.rankedSearch = ranked
+        }
+
+        // Results are still streaming in
+        ProgressBar {
+            Layout.fillWidth: true
+            Layout.preferredHeight: 2
+            indeterminate: true
+            // Hidden without leaving the layout, so the list doesn't jump while typing
+            opacity: promptListViewModel.searchComplete ? 0 : 1
         }
 
         // Folder chips
@@ -60,12 +71,14 @@ Page {
 
                 FolderChip {
                     text: "All"
+                    count: promptListViewModel.totalCount
                     selected: promptListViewModel.selectedFolderId === -1
                     onClicked: promptListViewModel.selectedFolderId = -1
                 }
 
                 FolderChip {
                     text: "Uncategorized"
+                    count: promptListViewModel.uncategorizedCount
                     selected: promptListViewModel.selectedFolderId === 0
                     onClicked: promptListViewModel.selectedFolderId = 0
                 }
@@ -75,6 +88,7 @@ Page {
 
                     FolderChip {
                         text: modelData.name
+                        count: modelData.promptCount
                         selected: promptListViewModel.selectedFolderId === modelData.id
                         onClicked: promptListViewModel.selectedFolderId = modelData.id
                     }
@@ -97,17 +111,16 @@ Page {
                     width: promptsList.width
                     promptId: model.id
                     title: model.title
-                    content: model.content
+                    preview: model.preview
+                    snippet: model.snippet
                     folderName: model.folderName || ""
                     updatedAt: model.updatedAt
 
                     onEditClicked: root.editPrompt(promptId)
                     onDeleteClicked: promptListViewModel.deletePrompt(promptId)
                     onDuplicateClicked: promptListViewModel.duplicatePrompt(promptId)
-                    onFillPlaceholdersClicked: root.fillPlaceholdersWithContent(promptId, model.content)
-                    onFillPlaceholdersWithContentClicked: function (content) {
-                        root.fillPlaceholdersWithContent(promptId, content);
-                    }
+                    // The full body is only fetched for the prompt being opened
+                    onFillPlaceholdersClicked: root.fillPlaceholdersWithContent(promptId, promptListViewModel.getPromptContent(promptId))
                 }
 
                 Rectangle {
@@ -126,7 +139,7 @@ Page {
         // Loading indicator
         BusyIndicator {
             Layout.alignment: Qt.AlignHCenter
-            visible: promptListViewModel.isLoading
+            visible: promptListViewModel.isLoading && promptsList.count === 0
             running: visible
         }
 
@@ -113,6 +113,16 @@ bool Database::createPromptsTable()
     if (!query.exec(createSearchIndex)) {
         qWarning() << "Could not create search index:" << query.lastError().text();
     }
+
+    // Per-folder counts and listings read this index instead of scanning the table
+    QString createFolderIndex = R"(
+        CREATE INDEX IF NOT EXISTS idx_prompts_folder
+        ON prompts(folder_id)
+    )";
+
+    if (!query.exec(createFolderIndex)) {
+        qWarning() << "Could not create folder index:" << query.lastError().text();
+    }
     
     return true;
 }
@@ -5,6 +5,7 @@
 #include <QSqlError>
 #include <QDebug>
 #include <QDateTime>
+#include <QHash>
 
 PromptDao::PromptDao(Database *database, QObject *parent)
     : QObject(parent), m_database(database)
@@ -278,18 +279,25 @@ QList<PromptWithFolder*> PromptDao::getPromptsWithFolders()
         return promptsWithFolders;
     }
     
+    // The join repeats the folder columns on every row; build each folder once and
+    // share it between its prompts
+    QHash<int, QSharedPointer<Folder>> folders;
     while (query.next()) {
         Prompt *prompt = createPromptFromQuery(query);
         if (!prompt) continue;
         
-        Folder *folder = nullptr;
+        QSharedPointer<Folder> folder;
         if (!query.value("folder_name").isNull()) {
             int folderId = query.value("folder_id").toInt();
-            QString folderName = query.value("folder_name").toString();
-            QDateTime folderCreatedAt = QDateTime::fromSecsSinceEpoch(query.value("folder_created_at").toLongLong());
-            QDateTime folderUpdatedAt = QDateTime::fromSecsSinceEpoch(query.value("folder_updated_at").toLongLong());
-            
-            folder = new Folder(folderId, folderName, folderCreatedAt, folderUpdatedAt, this);
+            folder = folders.value(folderId);
+            if (!folder) {
+                QString folderName = query.value("folder_name").toString();
+                QDateTime folderCreatedAt = QDateTime::fromSecsSinceEpoch(query.value("folder_created_at").toLongLong());
+                QDateTime folderUpdatedAt = QDateTime::fromSecsSinceEpoch(query.value("folder_updated_at").toLongLong());
+                
+                folder.reset(new Folder(folderId, folderName, folderCreatedAt, folderUpdatedAt));
+                folders.insert(folderId, folder);
+            }
         }
         
         PromptWithFolder *promptWithFolder = new PromptWithFolder(prompt, folder, this);
@@ -342,9 +350,14 @@ int PromptDao::getPromptCountByFolder(int folderId)
         return 0;
     }
     
+    // Folder IDs below 1 stand for the uncategorized prompts
     QSqlQuery query(m_database->database());
-    query.prepare("SELECT COUNT(*) FROM prompts WHERE folder_id = :folder_id");
-    query.bindValue(":folder_id", folderId);
+    if (folderId > 0) {
+        query.prepare("SELECT COUNT(*) FROM prompts WHERE folder_id = :folder_id");
+        query.bindValue(":folder_id", folderId);
+    } else {
+        query.prepare("SELECT COUNT(*) FROM prompts WHERE folder_id IS NULL");
+    }
     
     if (!query.exec() || !query.next()) {
         return 0;
@@ -47,7 +47,7 @@ int main(int argc, char *argv[])
 
     // Create repository
     // PromptRepository* repository = new SqlPromptRepository(database);
-    PromptRepository* repository = new MarkdownPromptRepository(promptsPath);
+    PromptRepository* repository = new MarkdownPromptRepository(promptsPath, settingsManager->scanWorkerCount());
     
     // Connect settings change to repository
     QObject::connect(settingsManager, &SettingsManager::promptsPathChanged, 
@@ -1,7 +1,7 @@
 #include "prompt.h"
 
 Prompt::Prompt(QObject *parent)
-    : QObject(parent), m_id(-1), m_folderId(-1)
+    : QObject(parent), m_id(-1), m_folderId(-1), m_contentLoaded(true)
 {
     QDateTime now = QDateTime::currentDateTime();
     m_createdAt = now;
@@ -12,7 +12,8 @@ Prompt::Prompt(int id, const QString &title, const QString &content,
                int folderId, const QDateTime &createdAt, const QDateTime &updatedAt,
                QObject *parent)
     : QObject(parent), m_id(id), m_title(title), m_content(content),
-      m_folderId(folderId), m_createdAt(createdAt), m_updatedAt(updatedAt)
+      m_folderId(folderId), m_createdAt(createdAt), m_updatedAt(updatedAt),
+      m_contentLoaded(true)
 {
 }
 
@@ -34,6 +35,7 @@ void Prompt::setTitle(const QString &title)
 
 void Prompt::setContent(const QString &content)
 {
+    m_contentLoaded = true;
     if (m_content != content) {
         m_content = content;
         emit contentChanged();
@@ -62,4 +64,4 @@ void Prompt::setUpdatedAt(const QDateTime &updatedAt)
         m_updatedAt = updatedAt;
         emit updatedAtChanged();
     }
-}
\ No newline at end of file
+}
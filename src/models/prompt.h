@@ -41,6 +41,10 @@ public:
     bool isValid() const { return m_id > 0; }
     void updateTimestamp() { setUpdatedAt(QDateTime::currentDateTime()); }
 
+    // False while a repository has deferred reading the body; setContent() clears it
+    bool isContentLoaded() const { return m_contentLoaded; }
+    void setContentLoaded(bool loaded) { m_contentLoaded = loaded; }
+
 signals:
     void idChanged();
     void titleChanged();
@@ -56,6 +60,7 @@ private:
     int m_folderId; // -1 means no folder
     QDateTime m_createdAt;
     QDateTime m_updatedAt;
+    bool m_contentLoaded;
 };
 
 #endif // PROMPT_H
\ No newline at end of file
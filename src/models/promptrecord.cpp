@@ -0,0 +1,78 @@
+#include "promptrecord.h"
+#include "prompt.h"
+
+class PromptRecordData : public QSharedData
+{
+public:
+    int id = -1;
+    QString title;
+    QString content;
+    int folderId = -1;
+    QDateTime createdAt;
+    QDateTime updatedAt;
+    bool contentLoaded = true;
+};
+
+PromptRecord::PromptRecord()
+    : d(new PromptRecordData)
+{
+}
+
+PromptRecord::PromptRecord(int id, const QString &title, const QString &content,
+                           int folderId, const QDateTime &createdAt, const QDateTime &updatedAt,
+                           bool contentLoaded)
+    : d(new PromptRecordData)
+{
+    d->id = id;
+    d->title = title;
+    d->content = content;
+    d->folderId = folderId;
+    d->createdAt = createdAt;
+    d->updatedAt = updatedAt;
+    d->contentLoaded = contentLoaded;
+}
+
+PromptRecord::PromptRecord(const Prompt *prompt)
+    : PromptRecord(prompt->id(), prompt->title(), prompt->content(), prompt->folderId(),
+                   prompt->createdAt(), prompt->updatedAt(), prompt->isContentLoaded())
+{
+}
+
+PromptRecord::PromptRecord(const PromptRecord &other) = default;
+PromptRecord &PromptRecord::operator=(const PromptRecord &other) = default;
+PromptRecord::~PromptRecord() = default;
+
+int PromptRecord::id() const
+{
+    return d->id;
+}
+
+QString PromptRecord::title() const
+{
+    return d->title;
+}
+
+QString PromptRecord::content() const
+{
+    return d->content;
+}
+
+int PromptRecord::folderId() const
+{
+    return d->folderId;
+}
+
+QDateTime PromptRecord::createdAt() const
+{
+    return d->createdAt;
+}
+
+QDateTime PromptRecord::updatedAt() const
+{
+    return d->updatedAt;
+}
+
+bool PromptRecord::isContentLoaded() const
+{
+    return d->contentLoaded;
+}
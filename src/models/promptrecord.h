@@ -0,0 +1,54 @@
+#ifndef PROMPTRECORD_H
+#define PROMPTRECORD_H
+
+#include <QSharedDataPointer>
+#include <QString>
+#include <QDateTime>
+#include <QMetaType>
+
+class Prompt;
+class PromptRecordData;
+
+// Immutable, implicitly shared snapshot of a prompt. Copying one only bumps a
+// reference count, so repositories can hand out lists of them without allocating
+// per row, and readers never have to free anything.
+class PromptRecord
+{
+    Q_GADGET
+    Q_PROPERTY(int id READ id CONSTANT)
+    Q_PROPERTY(QString title READ title CONSTANT)
+    Q_PROPERTY(QString content READ content CONSTANT)
+    Q_PROPERTY(int folderId READ folderId CONSTANT)
+    Q_PROPERTY(QDateTime createdAt READ createdAt CONSTANT)
+    Q_PROPERTY(QDateTime updatedAt READ updatedAt CONSTANT)
+    Q_PROPERTY(bool contentLoaded READ isContentLoaded CONSTANT)
+
+public:
+    PromptRecord();
+    PromptRecord(int id, const QString &title, const QString &content,
+                 int folderId, const QDateTime &createdAt, const QDateTime &updatedAt,
+                 bool contentLoaded = true);
+    explicit PromptRecord(const Prompt *prompt);
+    PromptRecord(const PromptRecord &other);
+    PromptRecord &operator=(const PromptRecord &other);
+    ~PromptRecord();
+
+    // Getters
+    int id() const;
+    QString title() const;
+    QString content() const;  // empty unless isContentLoaded()
+    int folderId() const;     // -1 means no folder
+    QDateTime createdAt() const;
+    QDateTime updatedAt() const;
+    bool isContentLoaded() const;
+
+    // Helper methods
+    bool isValid() const { return id() > 0; }
+
+private:
+    QSharedDataPointer<PromptRecordData> d;
+};
+
+Q_DECLARE_METATYPE(PromptRecord)
+
+#endif // PROMPTRECORD_H
@@ -10,6 +10,11 @@ PromptWithFolder::PromptWithFolder(Prompt *prompt, Folder *folder, QObject *pare
 {
 }
 
+PromptWithFolder::PromptWithFolder(Prompt *prompt, const QSharedPointer<Folder> &folder, QObject *parent)
+    : QObject(parent), m_prompt(prompt), m_folder(folder.data()), m_sharedFolder(folder)
+{
+}
+
 QString PromptWithFolder::folderName() const
 {
     return m_folder ? m_folder->name() : QString();
@@ -27,6 +32,9 @@ void PromptWithFolder::setFolder(Folder *folder)
 {
     if (m_folder != folder) {
         m_folder = folder;
+        if (m_sharedFolder.data() != folder) {
+            m_sharedFolder.reset();
+        }
         emit folderChanged();
         emit folderNameChanged();
     }
@@ -2,6 +2,7 @@
 #define PROMPTWITHFOLDER_H
 
 #include <QObject>
+#include <QSharedPointer>
 #include "prompt.h"
 #include "folder.h"
 
@@ -15,6 +16,9 @@ class PromptWithFolder : public QObject
 public:
     explicit PromptWithFolder(QObject *parent = nullptr);
     PromptWithFolder(Prompt *prompt, Folder *folder = nullptr, QObject *parent = nullptr);
+    // For result sets that share one read-only Folder between all prompts in it;
+    // the folder lives as long as any of them
+    PromptWithFolder(Prompt *prompt, const QSharedPointer<Folder> &folder, QObject *parent = nullptr);
 
     // Getters
     Prompt* prompt() const { return m_prompt; }
@@ -36,6 +40,7 @@ signals:
 private:
     Prompt *m_prompt;
     Folder *m_folder;
+    QSharedPointer<Folder> m_sharedFolder;
 };
 
 #endif // PROMPTWITHFOLDER_H
\ No newline at end of file
@@ -4,11 +4,52 @@
 #include <QDateTime>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QDebug>
 
-MarkdownPromptRepository::MarkdownPromptRepository(const QString &rootPath, QObject *parent)
+namespace {
+
+// Characters kept in file and directory names derived from titles
+const QRegularExpression &unsafeNameCharacters()
+{
+    static const QRegularExpression pattern("[^a-zA-Z0-9_\\-\\s]");
+    return pattern;
+}
+
+// Paths are compared the way the file system compares them
+// Marked prompts re-indexed on the calling thread when a search needs them; more
+// than this go to the index pool
+constexpr int kInlineIndexLimit = 64;
+
+QString pathKey(const QString &path)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return path.toCaseFolded();
+#else
+    return path;
+#endif
+}
+
+} // namespace
+
+MarkdownPromptRepository::MarkdownPromptRepository(const QString &rootPath, int scanWorkerCount, QObject *parent)
     : PromptRepository(parent), m_rootPath(rootPath)
 {
+    setScanWorkerCount(scanWorkerCount);
+    m_indexPool.setMaxThreadCount(1);
+
+    m_watcher = new VaultWatcher(this);
+    connect(m_watcher, &VaultWatcher::directoriesChanged, this, &MarkdownPromptRepository::onDirectoriesChanged);
+
+    m_writer = new PromptFileWriter(this);
+    connect(m_writer, &PromptFileWriter::fileWritten, this, &MarkdownPromptRepository::onFileWritten);
+    connect(m_writer, &PromptFileWriter::writeFailed, this, &MarkdownPromptRepository::onWriteFailed);
+    connect(m_writer, &PromptFileWriter::directoryChanged, this, &MarkdownPromptRepository::onDirectoryChanged);
+    connect(m_writer, &PromptFileWriter::idle, this, &MarkdownPromptRepository::onWriterIdle);
+
     QDir dir(m_rootPath);
     if (!dir.exists()) {
         dir.mkpath(".");
@@ -20,6 +61,15 @@ void MarkdownPromptRepository::setRootPath(const QString &rootPath)
 {
     if (m_rootPath == rootPath) return;
 
+    if (m_snapshotDirty) {
+        saveSnapshot();
+    }
+
+    // IDs belong to a vault; the new one brings its own from its snapshot
+    clearCache();
+    m_nextPromptId = 1;
+    m_nextFolderId = 1;
+
     m_rootPath = rootPath;
     QDir dir(m_rootPath);
     if (!dir.exists()) {
@@ -28,48 +78,301 @@ void MarkdownPromptRepository::setRootPath(const QString &rootPath)
     reload();
 }
 
+void MarkdownPromptRepository::setScanWorkerCount(int count)
+{
+    m_scanPool.setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+// The writer, a child, finishes every queued job, the snapshot included, before it
+// is destroyed
 MarkdownPromptRepository::~MarkdownPromptRepository()
 {
-    qDeleteAll(m_prompts);
-    qDeleteAll(m_folders);
+    if (m_snapshotDirty) {
+        saveSnapshot();
+    }
+    clearCache();
 }
 
-void MarkdownPromptRepository::reload()
+void MarkdownPromptRepository::clearCache()
 {
-    qDeleteAll(m_prompts);
-    qDeleteAll(m_folders);
+    qDeleteAll(m_prompts.values());
+    qDeleteAll(m_folders.values());
     m_prompts.clear();
     m_folders.clear();
-    m_nextPromptId = 1;
-    m_nextFolderId = 1;
+    m_promptsByFolder.clear();
+    m_folderByName.clear();
+    m_folderByLowerName.clear();
+    m_promptFiles.clear();
+    m_promptByPath.clear();
+    m_unloadedPromptIds.clear();
+    m_records.clear();
+    m_allRecords.clear();
+    m_staleRecords.clear();
+    m_allRecordsValid = false;
+    m_searchIndex.clear();
+    m_searchDirty.clear();
+    m_searchIndexing.clear(); // a running pass is dropped, the index changed under it
+}
+
+// Lists the vault as it is on disk, so anything the writer still has queued for it
+// would be missed or taken for an external change; within a session, reloads go
+// through requestReload()
+void MarkdownPromptRepository::reload()
+{
+    // IDs handed out in this session take precedence over the snapshot, so a reload
+    // never renumbers anything a view is holding. The counters only ever grow.
+    QHash<QString, int> knownFolderIds;
+    for (Folder *f : m_folders.values()) {
+        knownFolderIds.insert(f->name(), f->id());
+    }
+    QHash<QString, int> knownPromptIds;
+    const QHash<int, PromptFile> previousFiles = m_promptFiles;
+    for (auto it = previousFiles.constBegin(); it != previousFiles.constEnd(); ++it) {
+        knownPromptIds.insert(it->path, it.key());
+    }
+    clearCache();
+
+    PromptIndexSnapshot snapshot;
+    snapshot.open(PromptIndexSnapshot::defaultLocation(m_rootPath));
+    const QList<PromptIndexSnapshot::FolderEntry> snapshotFolders = snapshot.folders();
+    for (const PromptIndexSnapshot::FolderEntry &folder : snapshotFolders) {
+        if (!knownFolderIds.contains(folder.name)) {
+            knownFolderIds.insert(folder.name, folder.id);
+        }
+    }
+    m_nextPromptId = qMax(m_nextPromptId, snapshot.nextPromptId());
+    m_nextFolderId = qMax(m_nextFolderId, snapshot.nextFolderId());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Phase 1: list folders and files; folders get their IDs here
+    QList<ScanItem> items;
+    scanDirectory(QDir(m_rootPath), -1, knownFolderIds, items);
+    const qint64 listMs = timer.restart();
+
+    // Phase 2: read and parse every file on the scan pool. The ordered reduce keeps
+    // results aligned with items, whichever worker finishes first. In lazy mode only
+    // the front matter is read, and files whose size and mtime match the index
+    // snapshot are not opened at all.
+    const bool headerOnly = m_lazyLoading;
+    const PromptIndexSnapshot *index = &snapshot;
+    const QList<ParsedPrompt> parsed = QtConcurrent::blockingMapped<QList<ParsedPrompt>>(
+        &m_scanPool, items, [headerOnly, index](const ScanItem &item) {
+            PromptIndexSnapshot::Entry entry;
+            if (!index->find(item.relativePath, &entry)) {
+                return parsePromptFile(item.filePath, headerOnly);
+            }
+            const bool unchanged = entry.size == item.size && entry.modifiedMs == item.modifiedMs;
+            if (headerOnly && unchanged) {
+                ParsedPrompt result;
+                result.valid = true;
+                result.fromSnapshot = true;
+                result.matchesSnapshot = true;
+                result.snapshotId = entry.id;
+                result.hash = entry.hash;
+                result.title = entry.title;
+                result.createdAt = entry.createdAt;
+                result.updatedAt = entry.updatedAt;
+                return result;
+            }
+            ParsedPrompt result = parsePromptFile(item.filePath, headerOnly);
+            result.snapshotId = entry.id;
+            result.matchesSnapshot = result.valid && unchanged && result.hash == entry.hash;
+            return result;
+        });
+    const qint64 parseMs = timer.restart();
+
+    // Phase 3: prompt IDs. A file keeps the ID known for its path; a file new at its
+    // path takes over the ID of a vanished one with the same front matter hash and
+    // size, which is how renames made while the app was closed are recognised. Files
+    // with little or no front matter share a hash, so only a key matching exactly one
+    // vanished and one new file is paired; anything ambiguous gets a new ID rather
+    // than possibly another file's.
+    //
+    // Session IDs are all handed out before any snapshot ID, whatever the listing
+    // order: a file renamed in this session keeps its ID even when a new file now sits
+    // at its old path, which the snapshot still credits with that ID.
+    QList<int> ids(items.size(), -1);
+    QSet<int> usedIds;
+    auto assignKnown = [&](int i, int promptId) {
+        if (promptId > 0 && !usedIds.contains(promptId)) {
+            ids[i] = promptId;
+            usedIds.insert(promptId);
+            m_nextPromptId = qMax(m_nextPromptId, promptId + 1);
+        }
+    };
+    for (int i = 0; i < items.size(); ++i) {
+        if (parsed.at(i).valid) {
+            assignKnown(i, knownPromptIds.value(items.at(i).filePath, -1));
+        }
+    }
+    int unassigned = 0;
+    for (int i = 0; i < items.size(); ++i) {
+        if (!parsed.at(i).valid || ids.at(i) != -1) {
+            continue;
+        }
+        assignKnown(i, parsed.at(i).snapshotId);
+        if (ids.at(i) == -1) {
+            unassigned++;
+        }
+    }
+
+    bool idsChanged = unassigned > 0;
+    if (unassigned > 0) {
+        QMultiHash<QPair<quint64, qint64>, int> vanished;
+        auto addVanished = [&vanished, &usedIds](quint64 hash, qint64 size, int promptId) {
+            const QPair<quint64, qint64> key(hash, size);
+            // The session and the snapshot often know the same file
+            if (promptId > 0 && !usedIds.contains(promptId) && !vanished.contains(key, promptId)) {
+                vanished.insert(key, promptId);
+            }
+        };
+        for (auto it = previousFiles.constBegin(); it != previousFiles.constEnd(); ++it) {
+            addVanished(it->hash, it->size, it.key());
+        }
+        for (int i = 0; i < snapshot.count(); ++i) {
+            const PromptIndexSnapshot::Entry entry = snapshot.entryAt(i);
+            addVanished(entry.hash, entry.size, entry.id);
+        }
+
+        QHash<QPair<quint64, qint64>, int> appeared;
+        for (int i = 0; i < items.size(); ++i) {
+            if (parsed.at(i).valid && ids.at(i) == -1) {
+                appeared[qMakePair(parsed.at(i).hash, items.at(i).size)]++;
+            }
+        }
+
+        for (int i = 0; i < items.size(); ++i) {
+            const ParsedPrompt &p = parsed.at(i);
+            if (!p.valid || ids.at(i) != -1) {
+                continue;
+            }
+            int promptId = -1;
+            const QPair<quint64, qint64> key(p.hash, items.at(i).size);
+            if (appeared.value(key) == 1 && vanished.count(key) == 1) {
+                promptId = vanished.value(key);
+            }
+            if (promptId == -1) {
+                promptId = m_nextPromptId;
+            }
+            ids[i] = promptId;
+            usedIds.insert(promptId);
+            m_nextPromptId = qMax(m_nextPromptId, promptId + 1);
+        }
+    }
+
+    // The snapshot is rewritten only if anything in it is out of date: an entry, a
+    // counter, or an ID. Parsing a file, as non-lazy loads always do, doesn't count.
+    bool snapshotStale = idsChanged || m_nextPromptId != snapshot.nextPromptId() ||
+                         m_nextFolderId != snapshot.nextFolderId();
+    int snapshotEntriesUsed = 0;
+    const int snapshotCount = snapshot.count();
+    snapshot.close();
+
+    // Phase 4: merge on this thread, in listing order
+    int reusedCount = 0;
+    for (int i = 0; i < items.size(); ++i) {
+        const ParsedPrompt &p = parsed.at(i);
+        const ScanItem &item = items.at(i);
+        if (!p.valid) {
+            continue;
+        }
+        if (p.fromSnapshot) {
+            reusedCount++;
+        }
+
+        const int promptId = ids.at(i);
+        if (p.matchesSnapshot && p.snapshotId == promptId) {
+            snapshotEntriesUsed++;
+        } else {
+            snapshotStale = true;
+        }
+        Prompt *prompt = new Prompt(promptId, p.title, p.body, item.folderId,
+                                    p.createdAt, p.updatedAt, this);
+        if (!p.bodyLoaded) {
+            prompt->setContentLoaded(false);
+            m_unloadedPromptIds.insert(promptId);
+        }
+        addCachedPrompt(prompt);
+
+        PromptFile file;
+        file.path = item.filePath;
+        file.size = item.size;
+        file.modifiedMs = item.modifiedMs;
+        file.hash = p.hash;
+        setPromptFile(promptId, file);
+    }
+    // Indexed when a search first needs it, off the GUI thread (see prepareSearchIndex)
+    const qint64 mergeMs = timer.elapsed();
+
+    if (snapshotFolders.size() != m_folders.size()) {
+        snapshotStale = true;
+    }
+    for (const PromptIndexSnapshot::FolderEntry &folder : snapshotFolders) {
+        Folder *f = cachedFolder(folder.id);
+        if (!f || f->name() != folder.name) {
+            snapshotStale = true;
+            break;
+        }
+    }
+
+    // Entries left over belong to files that disappeared
+    m_snapshotDirty = snapshotStale || snapshotEntriesUsed != snapshotCount;
+    if (m_snapshotDirty) {
+        saveSnapshot();
+    }
+
+    watchVault();
+
+    m_lastScanTimings.fileCount = items.size();
+    m_lastScanTimings.reusedCount = reusedCount;
+    m_lastScanTimings.listMs = listMs;
+    m_lastScanTimings.parseMs = parseMs;
+    m_lastScanTimings.mergeMs = mergeMs;
 
-    scanDirectory(QDir(m_rootPath), -1);
     emit dataChanged();
 }
 
-void MarkdownPromptRepository::scanDirectory(const QDir &dir, int parentFolderId)
+// Reloads now, or once the writer has carried out what is queued; the GUI thread never
+// waits for it
+void MarkdownPromptRepository::requestReload()
+{
+    if (m_writer->isBusy()) {
+        m_reloadPending = true;
+        return;
+    }
+    m_reloadPending = false;
+    reload();
+}
+
+void MarkdownPromptRepository::onWriterIdle()
+{
+    // Only a hint: a save may have been queued since it was sent
+    if (m_reloadPending) {
+        requestReload();
+    }
+}
+
+void MarkdownPromptRepository::scanDirectory(const QDir &dir, int parentFolderId, const QHash<QString, int> &knownFolderIds, QList<ScanItem> &items)
 {
     // List Directories (Folders)
     QFileInfoList subdirList = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
     for (const QFileInfo &subdirInfo : subdirList) {
-        int folderId = m_nextFolderId++;
+        int folderId = knownFolderIds.value(subdirInfo.fileName(), -1);
+        if (folderId <= 0 || m_folders.contains(folderId)) {
+            folderId = m_nextFolderId;
+        }
+        m_nextFolderId = qMax(m_nextFolderId, folderId + 1);
+
         Folder *folder = new Folder(folderId, subdirInfo.fileName(), subdirInfo.birthTime(), subdirInfo.lastModified(), this);
-        // Store path in object? No, Folder model doesn't have path. 
-        // We implicitly assume: root + folderName = path. 
-        // Nested folders not fully supported by Folder model (flat list?), but we scan recursively.
-        // Existing app seems to assume flat folders based on database schema usually.
-        // Let's assume 1 level of folders for now as per likely app logic.
-        m_folders.append(folder);
+        addCachedFolder(folder);
         
-        // Scan for prompts inside this folder
+        // Queue prompts inside this folder
         QDir subDir(subdirInfo.absoluteFilePath());
         QFileInfoList fileList = subDir.entryInfoList(QStringList() << "*.md", QDir::Files, QDir::Name);
         for (const QFileInfo &fileInfo : fileList) {
-            int promptId = m_nextPromptId++;
-            Prompt *prompt = parsePromptFile(fileInfo.absoluteFilePath(), promptId, folderId);
-            if (prompt) {
-                m_prompts.append(prompt);
-            }
+            items.append(scanItem(fileInfo, subdirInfo.fileName() + "/" + fileInfo.fileName(), folderId));
         }
     }
 
@@ -77,41 +380,481 @@ void MarkdownPromptRepository::scanDirectory(const QDir &dir, int parentFolderId
     if (parentFolderId == -1) {
         QFileInfoList fileList = dir.entryInfoList(QStringList() << "*.md", QDir::Files, QDir::Name);
         for (const QFileInfo &fileInfo : fileList) {
-            int promptId = m_nextPromptId++;
-            Prompt *prompt = parsePromptFile(fileInfo.absoluteFilePath(), promptId, -1);
-            if (prompt) {
-                m_prompts.append(prompt);
+            items.append(scanItem(fileInfo, fileInfo.fileName(), -1));
+        }
+    }
+}
+
+MarkdownPromptRepository::ScanItem MarkdownPromptRepository::scanItem(const QFileInfo &fileInfo, const QString &relativePath, int folderId)
+{
+    ScanItem item;
+    item.filePath = fileInfo.absoluteFilePath();
+    item.relativePath = relativePath;
+    item.folderId = folderId;
+    item.size = fileInfo.size();
+    item.modifiedMs = fileInfo.lastModified().toMSecsSinceEpoch();
+    return item;
+}
+
+void MarkdownPromptRepository::watchVault()
+{
+    QStringList directories;
+    directories.append(QDir(m_rootPath).absolutePath());
+    for (Folder *folder : m_folders.values()) {
+        directories.append(folderDirectory(folder));
+    }
+    m_watcher->setDirectories(directories);
+}
+
+Prompt* MarkdownPromptRepository::cachedPrompt(int promptId) const
+{
+    return m_prompts.value(promptId);
+}
+
+Folder* MarkdownPromptRepository::cachedFolder(int folderId) const
+{
+    return m_folders.value(folderId);
+}
+
+// Exact match, as directory names on disk are case sensitive
+Folder* MarkdownPromptRepository::cachedFolderByName(const QString &name) const
+{
+    return m_folderByName.value(name);
+}
+
+void MarkdownPromptRepository::addCachedPrompt(Prompt *prompt)
+{
+    invalidateRecord(prompt->id());
+    m_searchIndex.appendToOrder(prompt->id());
+    m_prompts.insert(prompt->id(), prompt);
+    m_promptsByFolder[prompt->folderId()].insert(prompt->id(), prompt);
+    if (m_allRecordsValid) {
+        // Holds the prompt's place; the record itself is filled in on the next read
+        m_allRecords.insert(prompt->id(), PromptRecord());
+    }
+}
+
+// Unlinks the prompt from the cache; the caller deletes it
+void MarkdownPromptRepository::removeCachedPrompt(Prompt *prompt)
+{
+    invalidateRecord(prompt->id());
+    m_searchIndex.removeFromOrder(prompt->id());
+    m_prompts.remove(prompt->id());
+    m_allRecords.remove(prompt->id());
+    auto it = m_promptsByFolder.find(prompt->folderId());
+    if (it != m_promptsByFolder.end()) {
+        it->remove(prompt->id());
+        if (it->isEmpty()) {
+            m_promptsByFolder.erase(it);
+        }
+    }
+}
+
+void MarkdownPromptRepository::setCachedPromptFolder(Prompt *prompt, int folderId)
+{
+    if (prompt->folderId() == folderId) {
+        return;
+    }
+    invalidateRecord(prompt->id());
+
+    auto it = m_promptsByFolder.find(prompt->folderId());
+    if (it != m_promptsByFolder.end()) {
+        it->remove(prompt->id());
+        if (it->isEmpty()) {
+            m_promptsByFolder.erase(it);
+        }
+    }
+    prompt->setFolderId(folderId);
+    m_promptsByFolder[folderId].insert(prompt->id(), prompt);
+}
+
+void MarkdownPromptRepository::addCachedFolder(Folder *folder)
+{
+    m_folders.insert(folder->id(), folder);
+    m_folderByName.insert(folder->name(), folder);
+    m_folderByLowerName.insert(folder->name().toLower(), folder);
+}
+
+// Unlinks the folder from the cache; the caller deletes it and its prompts
+void MarkdownPromptRepository::removeCachedFolder(Folder *folder)
+{
+    m_folders.remove(folder->id());
+    unindexFolderName(folder);
+}
+
+void MarkdownPromptRepository::unindexFolderName(Folder *folder)
+{
+    if (m_folderByName.value(folder->name()) == folder) {
+        m_folderByName.remove(folder->name());
+    }
+    // Directories differing only in case can coexist on disk; the others stay indexed
+    m_folderByLowerName.remove(folder->name().toLower(), folder);
+}
+
+void MarkdownPromptRepository::setCachedFolderName(Folder *folder, const QString &name)
+{
+    unindexFolderName(folder);
+    folder->setName(name);
+    m_folderByName.insert(name, folder);
+    m_folderByLowerName.insert(name.toLower(), folder);
+}
+
+QString MarkdownPromptRepository::folderDirectory(const Folder *folder) const
+{
+    return QDir(m_rootPath).absoluteFilePath(folder->name());
+}
+
+// Applies a debounced batch of directory changes from the watcher as targeted cache
+// updates. Files are matched to cached prompts by path and compared by size and
+// mtime; a file that vanished and one that appeared with the same front matter hash
+// and size are treated as a rename and keep their prompt ID, unless other files in
+// the batch share that key.
+void MarkdownPromptRepository::onDirectoriesChanged(const QStringList &directories)
+{
+    if (m_reloadPending) {
+        return; // the whole vault is about to be listed again
+    }
+
+    QDir root(m_rootPath);
+    const QString rootDirectory = root.absolutePath();
+    QSet<QString> dirty(directories.cbegin(), directories.cend());
+
+    // Folders: one level below the root, matched by name
+    QStringList addedFolderNames;
+    QList<Folder*> removedFolders;
+    if (dirty.contains(rootDirectory)) {
+        QSet<QString> onDisk;
+        const QFileInfoList subdirList = root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QFileInfo &subdirInfo : subdirList) {
+            onDisk.insert(subdirInfo.fileName());
+            // A directory the writer is about to remove or rename isn't new
+            if (!cachedFolderByName(subdirInfo.fileName()) && !m_writer->isPending(subdirInfo.absoluteFilePath())) {
+                addedFolderNames.append(subdirInfo.fileName());
+                dirty.insert(subdirInfo.absoluteFilePath());
+            }
+        }
+        for (Folder *folder : m_folders.values()) {
+            // Nor is one it is about to create or rename into place gone
+            if (!onDisk.contains(folder->name()) && !m_writer->isPending(folderDirectory(folder))) {
+                removedFolders.append(folder);
+                dirty.remove(folderDirectory(folder));
+            }
+        }
+    }
+
+    // Known files in the affected directories, by path
+    QHash<QString, int> known;
+    auto addKnown = [this, &known](int folderId) {
+        const QList<Prompt*> prompts = m_promptsByFolder.value(folderId).values();
+        for (Prompt *p : prompts) {
+            known.insert(m_promptFiles.value(p->id()).path, p->id());
+        }
+    };
+    for (Folder *folder : std::as_const(removedFolders)) {
+        addKnown(folder->id());
+    }
+    for (const QString &directory : std::as_const(dirty)) {
+        if (directory == rootDirectory) {
+            addKnown(-1);
+        } else if (Folder *folder = cachedFolderByName(QFileInfo(directory).fileName())) {
+            addKnown(folder->id());
+        }
+    }
+
+    // Diff each directory's listing against the cache
+    QList<ScanItem> toParse;
+    QList<int> toParseIds; // existing prompt ID, or -1 for a new file
+    for (const QString &directory : std::as_const(dirty)) {
+        int folderId = -1;
+        QString prefix;
+        if (directory != rootDirectory) {
+            const QString name = QFileInfo(directory).fileName();
+            Folder *folder = cachedFolderByName(name);
+            if (folder) {
+                folderId = folder->id();
+            } else if (!addedFolderNames.contains(name)) {
+                continue; // not a folder we track
+            }
+            prefix = name + "/";
+        }
+
+        const QFileInfoList fileList = QDir(directory).entryInfoList(QStringList() << "*.md", QDir::Files, QDir::Name);
+        for (const QFileInfo &fileInfo : fileList) {
+            ScanItem item = scanItem(fileInfo, prefix + fileInfo.fileName(), folderId);
+            if (m_writer->isPending(item.filePath)) {
+                // Our own save in flight; its completion updates the cache
+                known.remove(item.filePath);
+                continue;
+            }
+            auto it = known.find(item.filePath);
+            if (it == known.end()) {
+                toParse.append(item);
+                toParseIds.append(-1);
+                continue;
             }
+            const int promptId = it.value();
+            known.erase(it);
+            const PromptFile &file = m_promptFiles[promptId];
+            if (file.size != item.size || file.modifiedMs != item.modifiedMs) {
+                toParse.append(item);
+                toParseIds.append(promptId);
+            }
+        }
+    }
+    // Whatever is left in known has disappeared, unless a save is about to create it
+    for (auto it = known.begin(); it != known.end();) {
+        if (m_writer->isPending(it.key())) {
+            it = known.erase(it);
+        } else {
+            ++it;
         }
     }
+
+    if (toParse.size() + known.size() > m_bulkChangeThreshold) {
+        requestReload();
+        return;
+    }
+    if (toParse.isEmpty() && known.isEmpty() && addedFolderNames.isEmpty() && removedFolders.isEmpty()) {
+        return;
+    }
+
+    const bool headerOnly = m_lazyLoading;
+    const QList<ParsedPrompt> parsed = QtConcurrent::blockingMapped<QList<ParsedPrompt>>(
+        &m_scanPool, toParse, [headerOnly](const ScanItem &item) {
+            return parsePromptFile(item.filePath, headerOnly);
+        });
+
+    // Pair up renames: vanished files by (hash, size). Files with little or no front
+    // matter share a hash, so a key shared by several vanished or new files pairs
+    // nothing; those get new IDs instead of possibly swapped ones.
+    QMultiHash<QPair<quint64, qint64>, int> vanished;
+    for (auto it = known.constBegin(); it != known.constEnd(); ++it) {
+        const PromptFile &file = m_promptFiles[it.value()];
+        vanished.insert(qMakePair(file.hash, file.size), it.value());
+    }
+    QHash<QPair<quint64, qint64>, int> appeared;
+    for (int i = 0; i < toParse.size(); ++i) {
+        if (parsed.at(i).valid && toParseIds.at(i) == -1) {
+            appeared[qMakePair(parsed.at(i).hash, toParse.at(i).size)]++;
+        }
+    }
+
+    // Apply. Signals go out once the cache is consistent again.
+    QList<Folder*> addedFolders;
+    for (const QString &name : std::as_const(addedFolderNames)) {
+        QFileInfo info(root.filePath(name));
+        Folder *folder = new Folder(m_nextFolderId++, name, info.birthTime(), info.lastModified(), this);
+        addCachedFolder(folder);
+        m_watcher->addDirectory(info.absoluteFilePath());
+        addedFolders.append(folder);
+    }
+
+    QList<Prompt*> addedPrompts;
+    QList<Prompt*> updatedPrompts;
+    for (int i = 0; i < toParse.size(); ++i) {
+        const ParsedPrompt &p = parsed.at(i);
+        if (!p.valid) {
+            continue; // unreadable for now; a later event will retry
+        }
+        ScanItem item = toParse.at(i);
+        if (item.folderId == -1 && item.relativePath.contains('/')) {
+            // File in a folder that was created in this batch
+            Folder *folder = cachedFolderByName(item.relativePath.section('/', 0, 0));
+            item.folderId = folder ? folder->id() : -1;
+        }
+
+        int promptId = toParseIds.at(i);
+        const QPair<quint64, qint64> key(p.hash, item.size);
+        if (promptId == -1 && appeared.value(key) == 1 && vanished.count(key) == 1) {
+            promptId = vanished.value(key);
+            known.remove(m_promptFiles.value(promptId).path);
+            vanished.remove(key);
+        }
+
+        Prompt *prompt = promptId == -1 ? nullptr : cachedPrompt(promptId);
+        if (prompt) {
+            prompt->setTitle(p.title);
+            setCachedPromptFolder(prompt, item.folderId);
+            prompt->setCreatedAt(p.createdAt);
+            prompt->setUpdatedAt(p.updatedAt);
+            updatedPrompts.append(prompt);
+        } else {
+            promptId = m_nextPromptId++;
+            prompt = new Prompt(promptId, p.title, QString(), item.folderId, p.createdAt, p.updatedAt, this);
+            addCachedPrompt(prompt);
+            addedPrompts.append(prompt);
+        }
+
+        prompt->setContent(p.body);
+        if (p.bodyLoaded) {
+            m_unloadedPromptIds.remove(promptId);
+        } else {
+            prompt->setContentLoaded(false);
+            m_unloadedPromptIds.insert(promptId);
+        }
+        invalidateRecord(promptId);
+
+        PromptFile file;
+        file.path = item.filePath;
+        file.size = item.size;
+        file.modifiedMs = item.modifiedMs;
+        file.hash = p.hash;
+        setPromptFile(promptId, file);
+    }
+
+    QList<int> deletedPromptIds;
+    for (auto it = known.constBegin(); it != known.constEnd(); ++it) {
+        Prompt *prompt = cachedPrompt(it.value());
+        if (prompt) {
+            removeCachedPrompt(prompt);
+            delete prompt;
+        }
+        removePromptFile(it.value());
+        m_unloadedPromptIds.remove(it.value());
+        deletedPromptIds.append(it.value());
+    }
+
+    QList<int> deletedFolderIds;
+    for (Folder *folder : std::as_const(removedFolders)) {
+        m_watcher->removeDirectory(folderDirectory(folder));
+        removeCachedFolder(folder);
+        deletedFolderIds.append(folder->id());
+        delete folder;
+    }
+
+    m_snapshotDirty = true;
+
+    for (Folder *folder : std::as_const(addedFolders)) {
+        emit folderAdded(folder);
+    }
+    for (Prompt *prompt : std::as_const(addedPrompts)) {
+        emit promptAdded(prompt);
+    }
+    for (Prompt *prompt : std::as_const(updatedPrompts)) {
+        emit promptUpdated(prompt);
+    }
+    for (int promptId : std::as_const(deletedPromptIds)) {
+        emit promptDeleted(promptId);
+    }
+    for (int folderId : std::as_const(deletedFolderIds)) {
+        emit folderDeleted(folderId);
+    }
 }
 
-Prompt* MarkdownPromptRepository::parsePromptFile(const QString &filePath, int id, int folderId)
+// Runs on scan pool threads: must not touch repository state.
+// With headerOnly set, reading stops at the closing "---" and the body is left empty.
+MarkdownPromptRepository::ParsedPrompt MarkdownPromptRepository::parsePromptFile(const QString &filePath, bool headerOnly)
 {
+    ParsedPrompt result;
+
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return nullptr;
+        return result;
     }
 
     QTextStream in(&file);
-    QString content = in.readAll();
-    file.close();
-
     QMap<QString, QString> frontMatter;
-    QString body = extractFrontMatter(content, frontMatter);
+    if (headerOnly) {
+        if (in.readLine() == "---") {
+            QMap<QString, QString> header;
+            while (!in.atEnd()) {
+                QString line = in.readLine();
+                if (line == "---") {
+                    frontMatter = header;
+                    break;
+                }
+                parseFrontMatterLine(line, header);
+            }
+        }
+    } else {
+        QString content = in.readAll();
+        result.body = extractFrontMatter(content, frontMatter);
+        result.bodyLoaded = true;
+    }
+    file.close();
+    result.hash = frontMatterHash(frontMatter);
     
-    QString title = frontMatter.value("title");
-    if (title.isEmpty()) {
-        title = QFileInfo(filePath).baseName();
+    result.title = frontMatter.value("title");
+    if (result.title.isEmpty()) {
+        result.title = QFileInfo(filePath).baseName();
     }
     
-    QDateTime createdAt = QDateTime::fromString(frontMatter.value("createdAt"), Qt::ISODate);
-    if (!createdAt.isValid()) createdAt = QFileInfo(filePath).birthTime();
+    result.createdAt = QDateTime::fromString(frontMatter.value("createdAt"), Qt::ISODate);
+    if (!result.createdAt.isValid()) result.createdAt = QFileInfo(filePath).birthTime();
     
-    QDateTime updatedAt = QDateTime::fromString(frontMatter.value("updatedAt"), Qt::ISODate);
-    if (!updatedAt.isValid()) updatedAt = QFileInfo(filePath).lastModified();
+    result.updatedAt = QDateTime::fromString(frontMatter.value("updatedAt"), Qt::ISODate);
+    if (!result.updatedAt.isValid()) result.updatedAt = QFileInfo(filePath).lastModified();
+
+    result.valid = true;
+    return result;
+}
+
+bool MarkdownPromptRepository::ensureContentLoaded(Prompt *prompt)
+{
+    if (prompt->isContentLoaded()) {
+        return true;
+    }
+
+    ParsedPrompt parsed = parsePromptFile(m_promptFiles.value(prompt->id()).path, false);
+    // A file that vanished or cannot be read counts as empty rather than being retried
+    prompt->setContent(parsed.body);
+    m_unloadedPromptIds.remove(prompt->id());
+    invalidateRecord(prompt->id());
+    return parsed.valid;
+}
+
+// Reads the bodies still missing among prompts in parallel on the scan pool
+void MarkdownPromptRepository::ensureContentLoaded(const QList<Prompt*> &prompts)
+{
+    if (m_unloadedPromptIds.isEmpty()) {
+        return;
+    }
 
-    return new Prompt(id, title, body, folderId, createdAt, updatedAt, this);
+    QList<Prompt*> pending;
+    QStringList paths;
+    for (Prompt *p : prompts) {
+        if (!p->isContentLoaded()) {
+            pending.append(p);
+            paths.append(m_promptFiles.value(p->id()).path);
+        }
+    }
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    const QList<ParsedPrompt> parsed = QtConcurrent::blockingMapped<QList<ParsedPrompt>>(
+        &m_scanPool, paths, [](const QString &path) { return parsePromptFile(path, false); });
+
+    for (int i = 0; i < pending.size(); ++i) {
+        pending.at(i)->setContent(parsed.at(i).body);
+        m_unloadedPromptIds.remove(pending.at(i)->id());
+        invalidateRecord(pending.at(i)->id());
+    }
+}
+
+void MarkdownPromptRepository::ensureAllContentLoaded()
+{
+    if (m_unloadedPromptIds.isEmpty()) {
+        return;
+    }
+
+    QList<Prompt*> pending;
+    pending.reserve(m_unloadedPromptIds.size());
+    for (int promptId : std::as_const(m_unloadedPromptIds)) {
+        if (Prompt *p = cachedPrompt(promptId)) {
+            pending.append(p);
+        }
+    }
+    ensureContentLoaded(pending);
+    m_unloadedPromptIds.clear();
+}
+
+Prompt* MarkdownPromptRepository::copyPrompt(const Prompt *prompt)
+{
+    Prompt *copy = new Prompt(prompt->id(), prompt->title(), prompt->content(), prompt->folderId(),
+                              prompt->createdAt(), prompt->updatedAt());
+    copy->setContentLoaded(prompt->isContentLoaded());
+    return copy;
 }
 
 QString MarkdownPromptRepository::extractFrontMatter(const QString &content, QMap<QString, QString> &frontMatter)
@@ -130,17 +873,22 @@ QString MarkdownPromptRepository::extractFrontMatter(const QString &content, QMa
 
     QStringList lines = frontMatterStr.split('\n');
     for (const QString &line : lines) {
-        int colon = line.indexOf(':');
-        if (colon != -1) {
-            QString key = line.left(colon).trimmed();
-            QString value = line.mid(colon + 1).trimmed();
-            frontMatter.insert(key, value);
-        }
+        parseFrontMatterLine(line, frontMatter);
     }
 
     return body;
 }
 
+void MarkdownPromptRepository::parseFrontMatterLine(const QString &line, QMap<QString, QString> &frontMatter)
+{
+    int colon = line.indexOf(':');
+    if (colon != -1) {
+        QString key = line.left(colon).trimmed();
+        QString value = line.mid(colon + 1).trimmed();
+        frontMatter.insert(key, value);
+    }
+}
+
 QString MarkdownPromptRepository::generateFrontMatter(const QMap<QString, QString> &frontMatter)
 {
     QString fm = "---\n";
@@ -158,195 +906,359 @@ bool MarkdownPromptRepository::savePrompt(Prompt *prompt)
 {
     if (!prompt) return false;
 
-    // Determine target folder path (Use internal lookup)
-    QString folderPath = m_rootPath;
-    if (prompt->folderId() != -1) {
-        Folder *f = nullptr;
-        for (Folder *folder : m_folders) {
-            if (folder->id() == prompt->folderId()) {
-                f = folder;
-                break;
+    Prompt *existing = nullptr;
+    const bool isNew = !prompt->isValid();
+    if (isNew) {
+        prompt->setId(m_nextPromptId++);
+        prompt->setCreatedAt(QDateTime::currentDateTime());
+    } else {
+        // Internal lookup to find existing cache object
+        existing = cachedPrompt(prompt->id());
+    }
+    prompt->setUpdatedAt(QDateTime::currentDateTime());
+
+    // The file name only has to be worked out again when the title or folder changed
+    const QString oldFilePath = existing ? m_promptFiles.value(existing->id()).path : QString();
+    QString filePath = oldFilePath;
+    if (filePath.isEmpty() || existing->title() != prompt->title() || existing->folderId() != prompt->folderId()) {
+        QString folderPath = QDir(m_rootPath).absolutePath();
+        if (prompt->folderId() != -1) {
+            Folder *f = cachedFolder(prompt->folderId());
+            if (f) {
+                folderPath = folderDirectory(f);
             }
         }
-        
-        if (f) {
-            folderPath = QDir(m_rootPath).filePath(f->name());
-        }
-    }
-    
-    QDir dir(folderPath);
-    if (!dir.exists()) dir.mkpath(".");
 
-    // Sanitize title for filename
-    QString safeTitle = prompt->title();
-    safeTitle.replace(QRegularExpression("[^a-zA-Z0-9_\\-\\s]"), "");
-    safeTitle = safeTitle.trimmed();
-    if (safeTitle.isEmpty()) safeTitle = "Untitled";
-    
-    QString fileName = safeTitle + ".md";
-    QString filePath = dir.filePath(fileName);
+        // The writer creates the directory, after any queued rename into it
+        filePath = availableFilePath(folderPath, sanitizedFileName(prompt->title()), prompt->id());
+    }
 
-    // If ID is new, assign it
-    if (!prompt->isValid()) {
-        prompt->setId(m_nextPromptId++);
-        prompt->setCreatedAt(QDateTime::currentDateTime());
-        prompt->setUpdatedAt(QDateTime::currentDateTime());
-        
+    if (isNew) {
         // Add COPY to cache so we own it
         Prompt* cacheCopy = new Prompt(prompt->id(), prompt->title(), prompt->content(), 
                                       prompt->folderId(), prompt->createdAt(), prompt->updatedAt(), this);
-        m_prompts.append(cacheCopy);
+        addCachedPrompt(cacheCopy);
         
         emit promptAdded(prompt); // Optimistic add to UI
     } else {
-        // Internal lookup to find existing cache object
-        Prompt* existing = nullptr;
-        for (Prompt *p : m_prompts) {
-            if (p->id() == prompt->id()) {
-                existing = p;
-                break;
-            }
-        }
-        
         if (existing) {
-             // Handle file operations (delete old if needed)
-             QString oldFolderPath = m_rootPath;
-             if (existing->folderId() != -1) {
-                 Folder *oldF = nullptr;
-                 for (Folder *f : m_folders) {
-                     if (f->id() == existing->folderId()) {
-                         oldF = f;
-                         break;
-                     }
-                 }
-                 if (oldF) oldFolderPath = QDir(m_rootPath).filePath(oldF->name());
-             }
-             
-             QString oldSafeTitle = existing->title();
-             oldSafeTitle.replace(QRegularExpression("[^a-zA-Z0-9_\\-\\s]"), "");
-             oldSafeTitle = oldSafeTitle.trimmed();
-             if (oldSafeTitle.isEmpty()) oldSafeTitle = "Untitled";
-             QString oldFilePath = QDir(oldFolderPath).filePath(oldSafeTitle + ".md");
-             
-             if (oldFilePath != filePath && QFile::exists(oldFilePath)) {
-                 QFile::remove(oldFilePath);
-             }
-             
              // Update cache object
              existing->setTitle(prompt->title());
              existing->setContent(prompt->content());
-             existing->setFolderId(prompt->folderId());
-             existing->setUpdatedAt(QDateTime::currentDateTime());
+             setCachedPromptFolder(existing, prompt->folderId());
+             existing->setUpdatedAt(prompt->updatedAt());
+             m_unloadedPromptIds.remove(existing->id());
+             invalidateRecord(existing->id());
         }
         
-        prompt->setUpdatedAt(QDateTime::currentDateTime());
         emit promptUpdated(prompt);
     }
     
-    writePromptFile(prompt, filePath);
-    emit dataChanged();
+    // The writer renames the old file when the name changed, then replaces it atomically
+    m_writer->write(prompt->id(), filePath, oldFilePath != filePath ? oldFilePath : QString(),
+                    promptFileData(prompt));
+    recordPromptFile(prompt->id(), filePath, frontMatterHash(promptFrontMatter(prompt)));
     return true;
 }
 
-void MarkdownPromptRepository::writePromptFile(Prompt *prompt, const QString &filePath)
+QString MarkdownPromptRepository::sanitizedFileName(const QString &title)
+{
+    QString safeTitle = title;
+    safeTitle.remove(unsafeNameCharacters());
+    safeTitle = safeTitle.trimmed();
+    if (safeTitle.isEmpty()) safeTitle = "Untitled";
+    return safeTitle;
+}
+
+// Returns directory/baseName.md, or "baseName (2).md" and so on when that file
+// belongs to another prompt or to something the cache does not know about yet.
+// The sanitizer strips parentheses, so suffixed names never clash with plain ones.
+QString MarkdownPromptRepository::availableFilePath(const QString &directory, const QString &baseName, int promptId) const
+{
+    const QDir dir(directory);
+    QString candidate = dir.filePath(baseName + ".md");
+    for (int n = 2; ; ++n) {
+        const int owner = m_promptByPath.value(pathKey(candidate), -1);
+        if (owner == promptId || (owner == -1 && !QFile::exists(candidate))) {
+            return candidate;
+        }
+        candidate = dir.filePath(QString("%1 (%2).md").arg(baseName).arg(n));
+    }
+}
+
+QMap<QString, QString> MarkdownPromptRepository::promptFrontMatter(const Prompt *prompt)
 {
     QMap<QString, QString> frontMatter;
     frontMatter.insert("title", prompt->title());
     frontMatter.insert("createdAt", prompt->createdAt().toString(Qt::ISODate));
     frontMatter.insert("updatedAt", prompt->updatedAt().toString(Qt::ISODate));
-    
-    QString content = generateFrontMatter(frontMatter) + prompt->content();
-    
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << content;
-        file.close();
-    }
+    return frontMatter;
 }
 
-bool MarkdownPromptRepository::deletePrompt(int promptId)
+// FNV-1a over the parsed key/value pairs, so it doesn't depend on whether a file was
+// read whole or header-only, nor on qHash seeding.
+quint64 MarkdownPromptRepository::frontMatterHash(const QMap<QString, QString> &frontMatter)
 {
-    Prompt *p = nullptr;
-    for (Prompt *prompt : m_prompts) {
-        if (prompt->id() == promptId) {
-            p = prompt;
-            break;
+    quint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](QStringView text) {
+        for (QChar c : text) {
+            hash = (hash ^ c.unicode()) * 1099511628211ULL;
         }
+        hash = (hash ^ 0xFFFF) * 1099511628211ULL;
+    };
+    for (auto it = frontMatter.constBegin(); it != frontMatter.constEnd(); ++it) {
+        mix(it.key());
+        mix(it.value());
     }
-    
-    if (!p) return false;
-    
-    QString folderPath = m_rootPath;
-    if (p->folderId() != -1) {
-        Folder *f = nullptr;
-        for (Folder *folder : m_folders) {
-            if (folder->id() == p->folderId()) {
-                f = folder;
-                break;
-            }
+    return hash;
+}
+
+// The file itself is written later; its size and mtime stay unknown until
+// onFileWritten() reports them
+void MarkdownPromptRepository::recordPromptFile(int promptId, const QString &filePath, quint64 hash)
+{
+    PromptFile file;
+    file.path = filePath;
+    file.hash = hash;
+    setPromptFile(promptId, file);
+    m_snapshotDirty = true;
+}
+
+void MarkdownPromptRepository::onFileWritten(int promptId, const QString &filePath, qint64 size, qint64 modifiedMs)
+{
+    auto it = m_promptFiles.find(promptId);
+    if (it == m_promptFiles.end() || it->path != filePath) {
+        return; // deleted or saved elsewhere since
+    }
+    it->size = size;
+    it->modifiedMs = modifiedMs;
+    m_snapshotDirty = true;
+}
+
+void MarkdownPromptRepository::onWriteFailed(int promptId, const QString &filePath, const QString &error)
+{
+    if (promptId != -1) {
+        qWarning() << "Failed to write prompt" << promptId << "to" << filePath << ":" << error;
+    } else if (filePath == PromptIndexSnapshot::defaultLocation(m_rootPath)) {
+        // Only a cache, written again after the next change
+        qWarning() << "Failed to write index snapshot" << filePath << ":" << error;
+        m_snapshotDirty = true;
+    } else {
+        // A folder change the cache already shows; take the vault as it really is
+        qWarning() << "Failed to update folder" << filePath << ":" << error;
+        requestReload();
+    }
+}
+
+// Watches follow directory jobs once they are done; a directory that doesn't exist
+// yet can't be watched
+void MarkdownPromptRepository::onDirectoryChanged(const QString &path, const QString &previousPath)
+{
+    if (!previousPath.isEmpty()) {
+        m_watcher->removeDirectory(previousPath);
+    }
+    if (QFileInfo(path).isDir()) {
+        m_watcher->addDirectory(path);
+    } else {
+        m_watcher->removeDirectory(path);
+    }
+}
+
+void MarkdownPromptRepository::setPromptFile(int promptId, const PromptFile &file)
+{
+    auto it = m_promptFiles.find(promptId);
+    if (it != m_promptFiles.end() && it->path != file.path) {
+        const QString oldKey = pathKey(it->path);
+        if (m_promptByPath.value(oldKey) == promptId) {
+            m_promptByPath.remove(oldKey);
         }
-        if (f) folderPath = QDir(m_rootPath).filePath(f->name());
     }
+    m_promptFiles.insert(promptId, file);
+    m_promptByPath.insert(pathKey(file.path), promptId);
+}
+
+void MarkdownPromptRepository::removePromptFile(int promptId)
+{
+    const PromptFile file = m_promptFiles.take(promptId);
+    const QString key = pathKey(file.path);
+    if (m_promptByPath.value(key) == promptId) {
+        m_promptByPath.remove(key);
+    }
+}
+
+void MarkdownPromptRepository::saveSnapshot()
+{
+    QDir root(m_rootPath);
+    PromptIndexSnapshot::Contents contents;
+    contents.nextPromptId = m_nextPromptId;
+    contents.nextFolderId = m_nextFolderId;
+    contents.entries.reserve(m_prompts.size());
+    for (Prompt *p : m_prompts.values()) {
+        const PromptFile file = m_promptFiles.value(p->id());
+        PromptIndexSnapshot::Entry entry;
+        entry.relativePath = root.relativeFilePath(file.path);
+        entry.id = p->id();
+        entry.size = file.size;
+        entry.modifiedMs = file.modifiedMs;
+        entry.hash = file.hash;
+        entry.title = p->title();
+        entry.createdAt = p->createdAt();
+        entry.updatedAt = p->updatedAt();
+        contents.entries.append(entry);
+    }
+    contents.folders.reserve(m_folders.size());
+    for (Folder *f : m_folders.values()) {
+        PromptIndexSnapshot::FolderEntry folder;
+        folder.name = f->name();
+        folder.id = f->id();
+        contents.folders.append(folder);
+    }
+
+    // Written on the writer thread, after the saves queued so far; it fills in the
+    // size and mtime of files those saves are about to write
+    m_writer->writeSnapshot(PromptIndexSnapshot::defaultLocation(m_rootPath), m_rootPath, contents);
+    m_snapshotDirty = false;
+}
+
+QByteArray MarkdownPromptRepository::promptFileData(const Prompt *prompt)
+{
+    QMap<QString, QString> frontMatter = promptFrontMatter(prompt);
     
-    QString safeTitle = p->title();
-    safeTitle.replace(QRegularExpression("[^a-zA-Z0-9_\\-\\s]"), "");
-    safeTitle = safeTitle.trimmed();
-    if (safeTitle.isEmpty()) safeTitle = "Untitled";
-    QString filePath = QDir(folderPath).filePath(safeTitle + ".md");
+    QString content = generateFrontMatter(frontMatter) + prompt->content();
+    return content.toUtf8();
+}
+
+bool MarkdownPromptRepository::deletePrompt(int promptId)
+{
+    Prompt *p = cachedPrompt(promptId);
+    if (!p) return false;
     
-    bool success = QFile::remove(filePath);
-    if (success) {
-        m_prompts.removeAll(p);
-        delete p;
-        emit promptDeleted(promptId);
-        emit dataChanged();
-    }
-    return success;
+    // Queued behind any pending save of the same prompt, which it cancels
+    m_writer->remove(promptId, m_promptFiles.value(promptId).path);
+
+    removeCachedPrompt(p);
+    removePromptFile(promptId);
+    m_unloadedPromptIds.remove(promptId);
+    m_snapshotDirty = true;
+    delete p;
+    emit promptDeleted(promptId);
+    return true;
 }
 
 Prompt* MarkdownPromptRepository::getPromptById(int promptId)
 {
-    for (Prompt *p : m_prompts) {
-        if (p->id() == promptId) {
-            // Return copy
-            return new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt());
-        }
-    }
-    return nullptr;
+    Prompt *p = cachedPrompt(promptId);
+    if (!p) return nullptr;
+
+    ensureContentLoaded(p);
+    // Return copy
+    return copyPrompt(p);
 }
 
+// The Prompt* API hands out complete prompts, so any bodies lazy loading deferred
+// are read first; the record API below leaves them to getPromptContent()
 QList<Prompt*> MarkdownPromptRepository::getAllPrompts()
 {
+    ensureAllContentLoaded();
     QList<Prompt*> result;
-    for (Prompt *p : m_prompts) {
-        result.append(new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt()));
+    result.reserve(m_prompts.size());
+    for (Prompt *p : m_prompts.values()) {
+        result.append(copyPrompt(p));
     }
     return result;
 }
 
 QList<Prompt*> MarkdownPromptRepository::getPromptsByFolder(int folderId)
 {
+    const QList<Prompt*> prompts = m_promptsByFolder.value(folderId).values();
+    ensureContentLoaded(prompts);
     QList<Prompt*> result;
-    for (Prompt *p : m_prompts) {
-        if (p->folderId() == folderId) {
-            result.append(new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt()));
-        }
+    result.reserve(prompts.size());
+    for (Prompt *p : prompts) {
+        result.append(copyPrompt(p));
     }
     return result;
 }
 
 QList<Prompt*> MarkdownPromptRepository::getPromptsWithoutFolder()
 {
-    QList<Prompt*> result;
-    for (Prompt *p : m_prompts) {
-        if (p->folderId() == -1) {
-            result.append(new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt()));
+    return getPromptsByFolder(-1);
+}
+
+QString MarkdownPromptRepository::getPromptContent(int promptId)
+{
+    Prompt *p = cachedPrompt(promptId);
+    if (!p) return QString();
+
+    ensureContentLoaded(p);
+    return p->content();
+}
+
+PromptRecord MarkdownPromptRepository::promptRecordById(int promptId)
+{
+    Prompt *p = cachedPrompt(promptId);
+    if (!p) return PromptRecord();
+
+    ensureContentLoaded(p);
+    return record(p);
+}
+
+// Built once per cache load; after that only the prompts that changed are patched in
+QList<PromptRecord> MarkdownPromptRepository::allPromptRecords()
+{
+    if (!m_allRecordsValid) {
+        m_allRecords.clear();
+        for (Prompt *p : m_prompts.values()) {
+            m_allRecords.insert(p->id(), record(p));
         }
+        m_staleRecords.clear();
+        m_allRecordsValid = true;
+    }
+    for (int promptId : std::as_const(m_staleRecords)) {
+        if (Prompt *p = cachedPrompt(promptId)) {
+            m_allRecords.insert(promptId, record(p));
+        }
+    }
+    m_staleRecords.clear();
+    return m_allRecords.values();
+}
+
+QList<PromptRecord> MarkdownPromptRepository::promptRecordsByFolder(int folderId)
+{
+    const QList<Prompt*> prompts = m_promptsByFolder.value(folderId).values();
+    QList<PromptRecord> result;
+    result.reserve(prompts.size());
+    for (Prompt *p : prompts) {
+        result.append(record(p));
     }
     return result;
 }
 
+QList<PromptRecord> MarkdownPromptRepository::promptRecordsWithoutFolder()
+{
+    return promptRecordsByFolder(-1);
+}
+
+// Records are rebuilt from the cached prompt only after it changed; until then every
+// reader shares the same one
+PromptRecord MarkdownPromptRepository::record(const Prompt *prompt)
+{
+    auto it = m_records.find(prompt->id());
+    if (it == m_records.end()) {
+        it = m_records.insert(prompt->id(), PromptRecord(prompt));
+    }
+    return it.value();
+}
+
+void MarkdownPromptRepository::invalidateRecord(int promptId)
+{
+    m_records.remove(promptId);
+    if (m_allRecordsValid) {
+        m_staleRecords.insert(promptId);
+    }
+    m_searchDirty.insert(promptId);
+}
+
 bool MarkdownPromptRepository::duplicatePrompt(int promptId)
 {
     // Implementation uses getPromptById which now returns a copy, so this is safe/unchanged
@@ -370,94 +1282,102 @@ bool MarkdownPromptRepository::saveFolder(Folder *folder)
     
     QString folderName = folder->name();
     // Sanitize
-    folderName.replace(QRegularExpression("[^a-zA-Z0-9_\\-\\s]"), "");
+    folderName.remove(unsafeNameCharacters());
     folderName = folderName.trimmed();
     
     QString folderPath = QDir(m_rootPath).filePath(folderName);
-    QDir dir(folderPath);
     
     if (folder->isValid()) {
         // Internal lookup
-        Folder *existing = nullptr;
-        for (Folder *f : m_folders) {
-            if (f->id() == folder->id()) {
-                existing = f;
-                break;
-            }
-        }
+        Folder *existing = cachedFolder(folder->id());
         
         if (existing && existing->name() != folderName) {
             QString oldPath = QDir(m_rootPath).filePath(existing->name());
-            QDir().rename(oldPath, folderPath);
-            existing->setName(folderName);
+            // Checked against what the disk will look like once the queue has run; the
+            // rename itself is queued behind the saves that still target oldPath
+            const bool sameDirectory = pathKey(oldPath) == pathKey(folderPath);
+            if (!QFileInfo(oldPath).isDir() && !m_writer->isPending(oldPath)) {
+                qWarning() << "Cannot rename folder" << oldPath << ": it no longer exists";
+                return false;
+            }
+            if (QFileInfo::exists(folderPath) && !sameDirectory && !m_writer->isPending(folderPath)) {
+                qWarning() << "Cannot rename folder" << oldPath << "to" << folderPath << ": the name is taken";
+                return false;
+            }
+            m_writer->renameDirectory(oldPath, folderPath);
+            setCachedFolderName(existing, folderName);
+
+            // Prompts inside moved with the directory
+            const QDir movedDir(folderDirectory(existing));
+            const QList<Prompt*> prompts = m_promptsByFolder.value(existing->id()).values();
+            for (Prompt *p : prompts) {
+                PromptFile file = m_promptFiles.value(p->id());
+                file.path = movedDir.absoluteFilePath(QFileInfo(file.path).fileName());
+                setPromptFile(p->id(), file);
+            }
+            m_snapshotDirty = true;
             emit folderUpdated(folder);
         }
     } else {
-        // New folder
-        if (dir.mkpath(".")) {
-            folder->setId(m_nextFolderId++);
-            // Create internal copy
-            Folder* cacheCopy = new Folder(folder->id(), folder->name(), folder->createdAt(), folder->updatedAt(), this);
-            m_folders.append(cacheCopy);
-            
-            emit folderAdded(folder);
-        }
+        // New folder; the writer creates the directory, a failure resyncs through reload
+        m_writer->makeDirectory(folderPath);
+        folder->setId(m_nextFolderId++);
+        // Create internal copy, named like the directory so external changes match it
+        Folder* cacheCopy = new Folder(folder->id(), folderName, folder->createdAt(), folder->updatedAt(), this);
+        addCachedFolder(cacheCopy);
+        m_snapshotDirty = true;
+
+        emit folderAdded(folder);
     }
     
-    emit dataChanged();
     return true;
 }
 
 bool MarkdownPromptRepository::deleteFolder(int folderId)
 {
-    Folder *f = nullptr;
-    for (Folder *folder : m_folders) {
-        if (folder->id() == folderId) {
-            f = folder;
-            break;
-        }
-    }
-    
+    Folder *f = cachedFolder(folderId);
     if (!f) return false;
     
     QString folderPath = QDir(m_rootPath).filePath(f->name());
-    QDir dir(folderPath);
-    
-    // removeRecursively
-    if (dir.removeRecursively()) {
-        // Also remove all contained prompts from memory
-        QList<Prompt*> promptsToRemove;
-        for (Prompt *p : m_prompts) {
-            if (p->folderId() == folderId) promptsToRemove.append(p);
-        }
-        for (Prompt *p : promptsToRemove) {
-            m_prompts.removeAll(p);
-            delete p;
-        }
-        
-        m_folders.removeAll(f);
-        delete f;
-        emit folderDeleted(folderId);
-        emit dataChanged();
-        return true;
+
+    // Queued behind the saves into it, which would otherwise recreate the directory;
+    // a failure resyncs through reload
+    m_writer->removeDirectory(folderPath);
+
+    // Also remove all contained prompts from memory
+    const QList<Prompt*> promptsToRemove = m_promptsByFolder.value(folderId).values();
+    QList<int> deletedPromptIds;
+    for (Prompt *p : promptsToRemove) {
+        deletedPromptIds.append(p->id());
+        removeCachedPrompt(p);
+        removePromptFile(p->id());
+        m_unloadedPromptIds.remove(p->id());
+        delete p;
     }
-    return false;
+    m_snapshotDirty = true;
+
+    removeCachedFolder(f);
+    delete f;
+    for (int promptId : std::as_const(deletedPromptIds)) {
+        emit promptDeleted(promptId);
+    }
+    emit folderDeleted(folderId);
+    return true;
 }
 
 Folder* MarkdownPromptRepository::getFolderById(int folderId)
 {
-    for (Folder *f : m_folders) {
-        if (f->id() == folderId) {
-            return new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt());
-        }
-    }
-    return nullptr;
+    Folder *f = cachedFolder(folderId);
+    if (!f) return nullptr;
+
+    return new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt());
 }
 
 QList<Folder*> MarkdownPromptRepository::getAllFolders()
 {
     QList<Folder*> result;
-    for (Folder *f : m_folders) {
+    result.reserve(m_folders.size());
+    for (Folder *f : m_folders.values()) {
         result.append(new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt()));
     }
     return result;
@@ -466,26 +1386,29 @@ QList<Folder*> MarkdownPromptRepository::getAllFolders()
 QList<Folder*> MarkdownPromptRepository::getFoldersWithCounts()
 {
     QList<Folder*> result;
-    for (Folder *f : m_folders) {
-        // Count internal prompts
-        int count = 0;
-        for (Prompt *p : m_prompts) {
-            if (p->folderId() == f->id()) count++;
-        }
-        
+    result.reserve(m_folders.size());
+    for (Folder *f : m_folders.values()) {
         // Return copy with count set
         Folder *copy = new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt());
-        copy->setPromptCount(count);
+        copy->setPromptCount(m_promptsByFolder.value(f->id()).size());
         result.append(copy);
     }
     return result;
 }
 
+int MarkdownPromptRepository::folderIdByName(const QString &name)
+{
+    Folder *f = m_folderByLowerName.value(name.toLower());
+    return f ? f->id() : -1;
+}
+
 bool MarkdownPromptRepository::folderNameExists(const QString &name, int excludeId)
 {
-    for (Folder *f : m_folders) {
-        if (f->id() == excludeId) continue;
-        if (f->name().compare(name, Qt::CaseInsensitive) == 0) return true;
+    const auto range = m_folderByLowerName.equal_range(name.toLower());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it.value()->id() != excludeId) {
+            return true;
+        }
     }
     return false;
 }
@@ -494,11 +1417,8 @@ bool MarkdownPromptRepository::folderNameExists(const QString &name, int exclude
 QList<Prompt*> MarkdownPromptRepository::searchPrompts(const QString &searchText)
 {
     QList<Prompt*> result;
-    for (Prompt *p : m_prompts) {
-        if (p->title().contains(searchText, Qt::CaseInsensitive) || 
-            p->content().contains(searchText, Qt::CaseInsensitive)) {
-            result.append(new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt()));
-        }
+    for (const PromptRecord &r : searchIndex().search(parseSearchQuery(searchText))) {
+        result.append(copyPrompt(cachedPrompt(r.id())));
     }
     return result;
 }
@@ -506,33 +1426,169 @@ QList<Prompt*> MarkdownPromptRepository::searchPrompts(const QString &searchText
 QList<Prompt*> MarkdownPromptRepository::searchPromptsInFolder(const QString &searchText, int folderId)
 {
     QList<Prompt*> result;
-    for (Prompt *p : m_prompts) {
-        if (p->folderId() == folderId) {
-            if (p->title().contains(searchText, Qt::CaseInsensitive) || 
-                p->content().contains(searchText, Qt::CaseInsensitive)) {
-                result.append(new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt()));
+    for (const PromptRecord &r : searchIndex().search(parseSearchQuery(searchText, folderId))) {
+        result.append(copyPrompt(cachedPrompt(r.id())));
+    }
+    return result;
+}
+
+QList<PromptRecord> MarkdownPromptRepository::searchPromptRecords(const QString &searchText)
+{
+    return searchIndex().search(parseSearchQuery(searchText));
+}
+
+QList<PromptRecord> MarkdownPromptRepository::searchPromptRecordsInFolder(const QString &searchText, int folderId)
+{
+    return searchIndex().search(parseSearchQuery(searchText, folderId));
+}
+
+// Every change to a prompt goes through invalidateRecord(), which marks it for the
+// index; syncing re-indexes only those, tokenizing on the scan pool
+void MarkdownPromptRepository::syncSearchIndex()
+{
+    // Including what a background pass is working on; changing the index here makes
+    // it drop its result
+    m_searchDirty.unite(m_searchIndexing);
+    if (!m_searchDirty.isEmpty()) {
+        QList<PromptRecord> changed;
+        for (int promptId : std::as_const(m_searchDirty)) {
+            if (Prompt *p = cachedPrompt(promptId)) {
+                changed.append(record(p));
+            } else {
+                m_searchIndex.remove(promptId);
             }
         }
+        m_searchDirty.clear();
+        m_searchIndex.update(changed, &m_scanPool);
+    }
+}
+
+PromptSearchIndex MarkdownPromptRepository::searchIndex()
+{
+    ensureAllContentLoaded();
+    syncSearchIndex();
+    return m_searchIndex;
+}
+
+bool MarkdownPromptRepository::prepareSearchIndex()
+{
+    if (m_indexWatcher) {
+        return false; // ready once its pass is adopted
+    }
+    if (m_unloadedPromptIds.isEmpty() && m_searchDirty.size() <= kInlineIndexLimit) {
+        syncSearchIndex();
+        return true;
+    }
+    startSearchIndexing();
+    return false;
+}
+
+// Reads the unread bodies and indexes them with the marked prompts on a copy of the
+// index; the GUI thread only collects records, which share their strings with the cache
+void MarkdownPromptRepository::startSearchIndexing()
+{
+    QList<PromptRecord> changed;
+    QList<int> removed;
+    for (int promptId : std::as_const(m_searchDirty)) {
+        if (Prompt *p = cachedPrompt(promptId)) {
+            if (p->isContentLoaded()) {
+                changed.append(record(p));
+            }
+        } else {
+            removed.append(promptId);
+        }
+    }
+    QList<PromptRecord> unread;
+    QStringList paths;
+    for (int promptId : std::as_const(m_unloadedPromptIds)) {
+        if (Prompt *p = cachedPrompt(promptId)) {
+            unread.append(record(p));
+            paths.append(m_promptFiles.value(promptId).path);
+        }
+    }
+    m_searchIndexing = m_searchDirty;
+    m_searchDirty.clear();
+
+    QThreadPool *scanPool = &m_scanPool;
+    m_indexWatcher = new QFutureWatcher<IndexedBatch>(this);
+    connect(m_indexWatcher, &QFutureWatcherBase::finished, this, &MarkdownPromptRepository::onSearchIndexed);
+    m_indexWatcher->setFuture(QtConcurrent::run(&m_indexPool,
+        [index = m_searchIndex, changed, removed, unread, paths, scanPool]() mutable {
+            IndexedBatch batch;
+            batch.baseGeneration = index.generation();
+            const QList<ParsedPrompt> parsed = QtConcurrent::blockingMapped<QList<ParsedPrompt>>(
+                scanPool, paths, [](const QString &path) { return parsePromptFile(path, false); });
+            for (int i = 0; i < unread.size(); ++i) {
+                const PromptRecord &r = unread.at(i);
+                changed.append(PromptRecord(r.id(), r.title(), parsed.at(i).body, r.folderId(), r.createdAt(),
+                                            r.updatedAt()));
+                batch.promptIds.append(r.id());
+                batch.bodies.append(parsed.at(i).body);
+            }
+            for (int promptId : std::as_const(removed)) {
+                index.remove(promptId);
+            }
+            index.update(changed, scanPool);
+            batch.index = index;
+            return batch;
+        }));
+}
+
+void MarkdownPromptRepository::onSearchIndexed()
+{
+    const IndexedBatch batch = m_indexWatcher->result();
+    m_indexWatcher->deleteLater();
+    m_indexWatcher = nullptr;
+    const QSet<int> handedOut = m_searchIndexing;
+    m_searchIndexing.clear();
+
+    // Anything that touched the index meanwhile, a listing order change included,
+    // makes the copy outdated; the bodies are kept either way
+    const bool adopted = m_searchIndex.generation() == batch.baseGeneration;
+    if (adopted) {
+        m_searchIndex = batch.index;
+    }
+    for (int i = 0; i < batch.promptIds.size(); ++i) {
+        const int promptId = batch.promptIds.at(i);
+        Prompt *p = cachedPrompt(promptId);
+        // Marked since the pass started: changed, moved or replaced, so the body
+        // read may not be the current one
+        if (!p || p->isContentLoaded() || m_searchDirty.contains(promptId)) {
+            continue;
+        }
+        p->setContent(batch.bodies.at(i));
+        m_unloadedPromptIds.remove(promptId);
+        invalidateRecord(promptId);
+        if (adopted) {
+            m_searchDirty.remove(promptId);
+        }
+    }
+    if (!adopted) {
+        m_searchDirty.unite(handedOut);
+    }
+
+    if (prepareSearchIndex()) {
+        emit searchIndexReady();
     }
-    return result;
 }
 
 // Combined operations
 QList<PromptWithFolder*> MarkdownPromptRepository::getPromptsWithFolders()
 {
+    ensureAllContentLoaded();
+
+    // Hash join: one shared copy per folder, found by ID
+    QHash<int, QSharedPointer<Folder>> folders;
+    folders.reserve(m_folders.size());
+    for (Folder *f : m_folders.values()) {
+        folders.insert(f->id(), QSharedPointer<Folder>(new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt())));
+    }
+
     QList<PromptWithFolder*> result;
-    for (Prompt *p : m_prompts) {
-        Folder *folderCopy = nullptr;
-        // Internal loop used to find folder to clone
-        for (Folder *f : m_folders) {
-            if (f->id() == p->folderId()) {
-                folderCopy = new Folder(f->id(), f->name(), f->createdAt(), f->updatedAt());
-                break;
-            }
-        }
-        
-        Prompt *promptCopy = new Prompt(p->id(), p->title(), p->content(), p->folderId(), p->createdAt(), p->updatedAt());
-        result.append(new PromptWithFolder(promptCopy, folderCopy));
+    result.reserve(m_prompts.size());
+    for (Prompt *p : m_prompts.values()) {
+        Prompt *promptCopy = copyPrompt(p);
+        result.append(new PromptWithFolder(promptCopy, folders.value(p->folderId())));
     }
     return result;
 }
@@ -540,19 +1596,16 @@ QList<PromptWithFolder*> MarkdownPromptRepository::getPromptsWithFolders()
 // Statistics
 int MarkdownPromptRepository::getPromptCount()
 {
-    return m_prompts.count();
+    return m_prompts.size();
 }
 
 int MarkdownPromptRepository::getFolderCount()
 {
-    return m_folders.count();
+    return m_folders.size();
 }
 
+// Folder IDs below 1 stand for the uncategorized prompts, as in the UI
 int MarkdownPromptRepository::getPromptCountByFolder(int folderId)
 {
-    int count = 0;
-    for (Prompt *p : m_prompts) {
-        if (p->folderId() == folderId) count++;
-    }
-    return count;
+    return m_promptsByFolder.value(folderId > 0 ? folderId : -1).size();
 }
@@ -2,20 +2,51 @@
 #define MARKDOWNPROMPTREPOSITORY_H
 
 #include "promptrepository.h"
+#include "promptindexsnapshot.h"
+#include "vaultwatcher.h"
+#include "promptfilewriter.h"
+#include "../utils/orderedidlist.h"
 #include <QDir>
 #include <QHash>
+#include <QSet>
 #include <QMap>
+#include <QDateTime>
+#include <QThreadPool>
+#include <QFutureWatcher>
 
 class MarkdownPromptRepository : public PromptRepository
 {
     Q_OBJECT
 
 public:
-    explicit MarkdownPromptRepository(const QString &rootPath, QObject *parent = nullptr);
+    // scanWorkerCount: threads used to read and parse files on reload (0 = one per core)
+    explicit MarkdownPromptRepository(const QString &rootPath, int scanWorkerCount = 0, QObject *parent = nullptr);
     ~MarkdownPromptRepository() override;
     
     void setRootPath(const QString &rootPath);
 
+    // Scan tuning and diagnostics
+    struct ScanTimings {
+        int fileCount = 0;
+        int reusedCount = 0; // files taken from the index snapshot without opening them
+        qint64 listMs = 0;   // directory listing on the calling thread
+        qint64 parseMs = 0;  // parallel read + parse on the scan pool
+        qint64 mergeMs = 0;  // ordered merge into the cache
+    };
+    void setScanWorkerCount(int count);
+    int scanWorkerCount() const { return m_scanPool.maxThreadCount(); }
+    ScanTimings lastScanTimings() const { return m_lastScanTimings; }
+
+    // Lazy mode reads only the front matter while scanning; bodies are read on first
+    // access. Prompt* results always carry theirs, PromptRecords may not (see
+    // getPromptContent). Takes effect on the next reload.
+    void setLazyLoading(bool enabled) { m_lazyLoading = enabled; }
+    bool lazyLoading() const { return m_lazyLoading; }
+
+    // External edits touching more files than this in one debounced batch trigger a
+    // full reload instead of per-file updates
+    void setBulkChangeThreshold(int files) { m_bulkChangeThreshold = files; }
+
     // Prompt operations
     bool savePrompt(Prompt *prompt) override;
     bool deletePrompt(int promptId) override;
@@ -24,6 +55,19 @@ public:
     QList<Prompt*> getPromptsByFolder(int folderId) override;
     QList<Prompt*> getPromptsWithoutFolder() override;
     bool duplicatePrompt(int promptId) override;
+    QString getPromptContent(int promptId) override;
+
+    // Record snapshots, shared with the cache until a prompt changes
+    PromptRecord promptRecordById(int promptId) override;
+    QList<PromptRecord> allPromptRecords() override;
+    QList<PromptRecord> promptRecordsByFolder(int folderId) override;
+    QList<PromptRecord> promptRecordsWithoutFolder() override;
+    QList<PromptRecord> searchPromptRecords(const QString &searchText) override;
+    QList<PromptRecord> searchPromptRecordsInFolder(const QString &searchText, int folderId) override;
+    PromptSearchIndex searchIndex() override;
+    // Unread bodies and large batches of changes are indexed on a worker thread
+    bool prepareSearchIndex() override;
+    int folderIdByName(const QString &name) override;
     
     // Folder operations
     bool saveFolder(Folder *folder) override;
@@ -45,26 +89,151 @@ public:
     int getFolderCount() override;
     int getPromptCountByFolder(int folderId) override;
 
+private slots:
+    void onDirectoriesChanged(const QStringList &directories);
+    void onFileWritten(int promptId, const QString &filePath, qint64 size, qint64 modifiedMs);
+    void onWriteFailed(int promptId, const QString &filePath, const QString &error);
+    void onDirectoryChanged(const QString &path, const QString &previousPath);
+    void onWriterIdle();
+
 private:
+    // A file found while listing the vault, in directory order
+    struct ScanItem {
+        QString filePath;
+        QString relativePath;
+        int folderId = -1;
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+    };
+
+    // A background indexing pass; adopted only if m_searchIndex is still at
+    // baseGeneration, which it was copied from
+    struct IndexedBatch {
+        PromptSearchIndex index;
+        quint64 baseGeneration = 0;
+        QList<int> promptIds; // bodies read, for the cache
+        QStringList bodies;
+    };
+
+    // Result of parsing one file; produced on a worker thread, so no QObjects here
+    struct ParsedPrompt {
+        bool valid = false;
+        bool bodyLoaded = false;
+        bool fromSnapshot = false;
+        bool matchesSnapshot = false; // size, mtime and front matter as the snapshot has them
+        int snapshotId = -1;    // ID recorded in the snapshot for this path, if any
+        quint64 hash = 0;
+        QString title;
+        QString body;
+        QDateTime createdAt;
+        QDateTime updatedAt;
+    };
+
+    // What is known about each prompt's file; also the source of the index snapshot
+    struct PromptFile {
+        QString path;           // absolute
+        qint64 size = -1;       // -1 if unknown, which never matches a snapshot entry
+        qint64 modifiedMs = 0;
+        quint64 hash = 0;       // frontMatterHash() of the file's front matter
+    };
+
     void reload();
-    void scanDirectory(const QDir &dir, int parentFolderId);
-    Prompt* parsePromptFile(const QString &filePath, int id, int folderId);
-    void writePromptFile(Prompt *prompt, const QString &filePath);
-    QString extractFrontMatter(const QString &content, QMap<QString, QString> &frontMatter);
+    void requestReload();
+    void clearCache();
+    void scanDirectory(const QDir &dir, int parentFolderId, const QHash<QString, int> &knownFolderIds, QList<ScanItem> &items);
+    static ParsedPrompt parsePromptFile(const QString &filePath, bool headerOnly);
+    static void parseFrontMatterLine(const QString &line, QMap<QString, QString> &frontMatter);
+    bool ensureContentLoaded(Prompt *prompt);
+    void ensureContentLoaded(const QList<Prompt*> &prompts);
+    void ensureAllContentLoaded();
+    static Prompt* copyPrompt(const Prompt *prompt);
+    PromptRecord record(const Prompt *prompt);
+    void invalidateRecord(int promptId);
+    void syncSearchIndex();
+    void startSearchIndexing();
+    void onSearchIndexed();
+    static QMap<QString, QString> promptFrontMatter(const Prompt *prompt);
+    static quint64 frontMatterHash(const QMap<QString, QString> &frontMatter);
+    QByteArray promptFileData(const Prompt *prompt);
+    void recordPromptFile(int promptId, const QString &filePath, quint64 hash);
+    static QString sanitizedFileName(const QString &title);
+    QString availableFilePath(const QString &directory, const QString &baseName, int promptId) const;
+    void saveSnapshot();
+    Prompt* cachedPrompt(int promptId) const;
+    Folder* cachedFolder(int folderId) const;
+    Folder* cachedFolderByName(const QString &name) const;
+    void addCachedPrompt(Prompt *prompt);
+    void removeCachedPrompt(Prompt *prompt);
+    void setCachedPromptFolder(Prompt *prompt, int folderId);
+    void addCachedFolder(Folder *folder);
+    void removeCachedFolder(Folder *folder);
+    void setCachedFolderName(Folder *folder, const QString &name);
+    void setPromptFile(int promptId, const PromptFile &file);
+    void removePromptFile(int promptId);
+    void unindexFolderName(Folder *folder);
+    QString folderDirectory(const Folder *folder) const;
+    static ScanItem scanItem(const QFileInfo &fileInfo, const QString &relativePath, int folderId);
+    void watchVault();
+    static QString extractFrontMatter(const QString &content, QMap<QString, QString> &frontMatter);
     QString generateFrontMatter(const QMap<QString, QString> &frontMatter);
 
     QString m_rootPath;
     
-    // In-memory cache
-    QList<Prompt*> m_prompts;
-    QList<Folder*> m_folders;
+    // In-memory cache. The lists own the objects, keep listing order and are keyed by
+    // ID; they and the indexes below must be updated through the add/remove/set
+    // helpers. Point operations on them are amortized O(1) as long as no list taken
+    // from values() is kept across a change (see OrderedIdList).
+    OrderedIdList<Prompt*> m_prompts;
+    OrderedIdList<Folder*> m_folders;
+    QHash<int, OrderedIdList<Prompt*>> m_promptsByFolder; // -1 for prompts without a folder
+    QHash<QString, Folder*> m_folderByName;
+    QMultiHash<QString, Folder*> m_folderByLowerName; // names can differ only in case on disk
+
+    // Record API: one record per prompt, built on first read and dropped by
+    // invalidateRecord() whenever the prompt changes. The full list follows the
+    // cache's order; changed prompts are patched into it when it is next read.
+    QHash<int, PromptRecord> m_records;
+    OrderedIdList<PromptRecord> m_allRecords;
+    QSet<int> m_staleRecords;
+    bool m_allRecordsValid = false;
+
+    // Search state over every prompt whose body is loaded, brought up to date with
+    // the prompts invalidateRecord() marked before each search. Its listing order
+    // follows m_prompts point by point.
+    PromptSearchIndex m_searchIndex;
+    QSet<int> m_searchDirty;
+    QSet<int> m_searchIndexing; // marked prompts handed to the running background pass
     
-    // ID management
+    // ID management. IDs are stable: they are persisted in the index snapshot and
+    // kept across reloads, and never reused within a vault.
     int m_nextPromptId = 1;
     int m_nextFolderId = 1;
-    
-    // Mappings to persist connections between IDs and Files across reloads (if possible)
-    // For this version, IDs are ephemeral and reset on restart/reload
+
+    // Scan pipeline
+    QThreadPool m_scanPool;
+    ScanTimings m_lastScanTimings;
+
+    // Background indexing: one pass at a time, which reads on the scan pool. Declared
+    // after it so the pass is finished before the scan pool goes away.
+    QThreadPool m_indexPool;
+    QFutureWatcher<IndexedBatch> *m_indexWatcher = nullptr;
+
+    // Lazy body loading
+    bool m_lazyLoading = true;
+    QHash<int, PromptFile> m_promptFiles;  // see setPromptFile()/removePromptFile()
+    QHash<QString, int> m_promptByPath;    // file path -> prompt ID, keyed by pathKey()
+    QSet<int> m_unloadedPromptIds;       // prompts whose body has not been read yet
+
+    // Set when m_promptFiles no longer matches the snapshot on disk
+    bool m_snapshotDirty = false;
+
+    // External change tracking
+    VaultWatcher *m_watcher;
+    int m_bulkChangeThreshold = 2000;
+    bool m_reloadPending = false;    // waiting for the writer to go idle
+
+    // Saves and deletes go to disk on this thread
+    PromptFileWriter *m_writer;
 };
 
 #endif // MARKDOWNPROMPTREPOSITORY_H
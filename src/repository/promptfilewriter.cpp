@@ -0,0 +1,313 @@
+#include "promptfilewriter.h"
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QDebug>
+
+PromptFileWriter::PromptFileWriter(QObject *parent)
+    : QThread(parent)
+{
+}
+
+PromptFileWriter::~PromptFileWriter()
+{
+    flush();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobAvailable.wakeAll();
+    }
+    wait();
+}
+
+void PromptFileWriter::write(int promptId, const QString &filePath, const QString &previousPath, const QByteArray &data)
+{
+    Job job;
+    job.kind = JobKind::Write;
+    job.promptId = promptId;
+    job.filePath = filePath;
+    job.previousPath = previousPath;
+    job.data = data;
+    enqueue(job);
+}
+
+void PromptFileWriter::remove(int promptId, const QString &filePath)
+{
+    Job job;
+    job.kind = JobKind::Remove;
+    job.promptId = promptId;
+    job.filePath = filePath;
+    enqueue(job);
+}
+
+void PromptFileWriter::writeSnapshot(const QString &filePath, const QString &rootPath,
+                                     const PromptIndexSnapshot::Contents &contents)
+{
+    Job job;
+    job.kind = JobKind::Snapshot;
+    job.filePath = filePath;
+    job.rootPath = rootPath;
+    job.contents = contents;
+    enqueue(job);
+}
+
+void PromptFileWriter::makeDirectory(const QString &path)
+{
+    Job job;
+    job.kind = JobKind::MakeDirectory;
+    job.filePath = path;
+    enqueue(job);
+}
+
+void PromptFileWriter::renameDirectory(const QString &path, const QString &newPath)
+{
+    Job job;
+    job.kind = JobKind::RenameDirectory;
+    job.filePath = newPath;
+    job.previousPath = path;
+    enqueue(job);
+}
+
+void PromptFileWriter::removeDirectory(const QString &path)
+{
+    Job job;
+    job.kind = JobKind::RemoveDirectory;
+    job.filePath = path;
+    enqueue(job);
+}
+
+void PromptFileWriter::enqueue(Job job)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const bool barrier = job.kind != JobKind::Write && job.kind != JobKind::Remove;
+    quint64 waiting = 0;
+    if (job.kind == JobKind::Snapshot) {
+        waiting = m_snapshotJob;
+    } else if (!barrier) {
+        waiting = m_promptJobs.value(job.promptId);
+    }
+    if (job.kind == JobKind::Snapshot && waiting) {
+        // Has to come after the saves queued since, so it goes last
+        m_order.removeOne(waiting);
+        m_jobs.remove(waiting);
+        m_snapshotJob = 0;
+    } else if (waiting) {
+        // The waiting job never ran, so the file on disk is still where it expected
+        // to find it
+        Job &previous = m_jobs[waiting];
+        if (!previous.previousPath.isEmpty()) {
+            job.previousPath = previous.previousPath;
+        } else if (job.kind == JobKind::Remove && previous.kind == JobKind::Write &&
+                   previous.filePath != job.filePath) {
+            job.previousPath = previous.filePath;
+        }
+        if (job.previousPath == job.filePath) {
+            job.previousPath.clear();
+        }
+        previous = job;
+        m_jobAvailable.wakeOne();
+        return;
+    }
+
+    const quint64 key = m_nextKey++;
+    if (barrier) {
+        // A later save folded into a job ahead of this one would change a file after
+        // the snapshot took its entry, or land in a directory about to be moved or
+        // removed; later saves queue behind it instead
+        m_promptJobs.clear();
+        if (job.kind == JobKind::Snapshot) {
+            m_snapshotJob = key;
+        }
+    } else {
+        m_promptJobs.insert(job.promptId, key);
+    }
+    m_order.append(key);
+    m_jobs.insert(key, job);
+
+    if (!isRunning()) {
+        start(QThread::LowPriority);
+    }
+    m_jobAvailable.wakeOne();
+}
+
+void PromptFileWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_busy || !m_order.isEmpty()) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+bool PromptFileWriter::isPending(const QString &filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_busy && touches(m_current, filePath)) {
+        return true;
+    }
+    for (const Job &job : m_jobs) {
+        if (touches(job, filePath)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PromptFileWriter::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_busy || !m_order.isEmpty();
+}
+
+bool PromptFileWriter::touches(const Job &job, const QString &filePath)
+{
+    switch (job.kind) {
+    case JobKind::Snapshot:
+        return false; // kept outside the vault
+    case JobKind::Write:
+    case JobKind::Remove:
+        return job.filePath == filePath || job.previousPath == filePath;
+    default:
+        break;
+    }
+
+    const auto within = [&filePath](const QString &directory) {
+        return !directory.isEmpty() && filePath.startsWith(directory) &&
+               (filePath.size() == directory.size() || filePath.at(directory.size()) == QLatin1Char('/'));
+    };
+    return within(job.filePath) || within(job.previousPath);
+}
+
+void PromptFileWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_order.isEmpty() && !m_stopping) {
+            m_jobAvailable.wait(&m_mutex);
+        }
+        if (m_order.isEmpty()) {
+            break;
+        }
+
+        const quint64 key = m_order.takeFirst();
+        m_current = m_jobs.take(key);
+        if (m_current.kind == JobKind::Snapshot) {
+            m_snapshotJob = 0;
+        } else if (m_current.promptId != -1 && m_promptJobs.value(m_current.promptId) == key) {
+            m_promptJobs.remove(m_current.promptId);
+        }
+        m_busy = true;
+        locker.unlock();
+
+        QString error;
+        const bool ok = process(m_current, &error);
+        if (!ok) {
+            emit writeFailed(m_current.promptId, m_current.filePath, error);
+        } else if (m_current.kind == JobKind::Write) {
+            const QFileInfo info(m_current.filePath);
+            emit fileWritten(m_current.promptId, m_current.filePath, info.size(),
+                             info.lastModified().toMSecsSinceEpoch());
+        } else if (m_current.kind != JobKind::Remove && m_current.kind != JobKind::Snapshot) {
+            emit directoryChanged(m_current.filePath, m_current.previousPath);
+        }
+
+        locker.relock();
+        m_busy = false;
+        m_current = Job();
+        if (m_order.isEmpty()) {
+            m_idle.wakeAll();
+            locker.unlock();
+            emit idle();
+            locker.relock();
+        }
+    }
+}
+
+// Runs on the writer thread
+bool PromptFileWriter::process(Job &job, QString *error)
+{
+    if (job.kind == JobKind::Snapshot) {
+        const QDir root(job.rootPath);
+        for (PromptIndexSnapshot::Entry &entry : job.contents.entries) {
+            if (entry.size == -1) {
+                const QFileInfo info(root.absoluteFilePath(entry.relativePath));
+                if (info.exists()) {
+                    entry.size = info.size();
+                    entry.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+                }
+            }
+        }
+        if (!PromptIndexSnapshot::write(job.filePath, std::move(job.contents))) {
+            *error = QString("Cannot write index snapshot %1").arg(job.filePath);
+            return false;
+        }
+        return true;
+    }
+
+    if (job.kind == JobKind::MakeDirectory) {
+        if (!QDir().mkpath(job.filePath)) {
+            *error = QString("Cannot create %1").arg(job.filePath);
+            return false;
+        }
+        return true;
+    }
+    if (job.kind == JobKind::RenameDirectory) {
+        if (QFileInfo::exists(job.filePath) && QFileInfo(job.filePath) != QFileInfo(job.previousPath)) {
+            *error = QString("%1 already exists").arg(job.filePath);
+            return false;
+        }
+        if (!QDir().rename(job.previousPath, job.filePath)) {
+            *error = QString("Cannot rename %1 to %2").arg(job.previousPath, job.filePath);
+            return false;
+        }
+        return true;
+    }
+    if (job.kind == JobKind::RemoveDirectory) {
+        QDir dir(job.filePath);
+        if (dir.exists() && !dir.removeRecursively()) {
+            *error = QString("Cannot remove %1").arg(job.filePath);
+            return false;
+        }
+        return true;
+    }
+
+    if (job.kind == JobKind::Remove) {
+        if (!job.previousPath.isEmpty()) {
+            QFile::remove(job.previousPath);
+        }
+        if (QFile::exists(job.filePath) && !QFile::remove(job.filePath)) {
+            *error = QString("Cannot remove %1").arg(job.filePath);
+            return false;
+        }
+        return true;
+    }
+
+    // The directory may have been removed by an earlier job, or not be there yet
+    QDir().mkpath(QFileInfo(job.filePath).absolutePath());
+
+    // Moving the old file first keeps its identity for sync tools and editors; if
+    // that fails the new file is written and the old one removed afterwards
+    bool removePrevious = false;
+    if (!job.previousPath.isEmpty() && QFile::exists(job.previousPath)) {
+        removePrevious = !QFile::rename(job.previousPath, job.filePath);
+    }
+
+    QSaveFile file(job.filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        *error = file.errorString();
+        return false;
+    }
+    file.write(job.data);
+    if (!file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+
+    if (removePrevious) {
+        QFile::remove(job.previousPath);
+    }
+    return true;
+}
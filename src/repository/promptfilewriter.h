@@ -0,0 +1,91 @@
+#ifndef PROMPTFILEWRITER_H
+#define PROMPTFILEWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include "promptindexsnapshot.h"
+
+// Background writer for prompt files, so saving never blocks the GUI thread on disk.
+// Jobs run in the order they were queued. A save queued while an earlier one for the
+// same prompt is still waiting replaces it in place, unless a directory job or a
+// snapshot was queued in between: those see the files as they are when they run, so
+// later saves stay behind them. Files are written through QSaveFile, so a crash
+// leaves either the old or the new file, never a truncated one.
+class PromptFileWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit PromptFileWriter(QObject *parent = nullptr);
+    ~PromptFileWriter() override;
+
+    // previousPath is where the prompt's file is now, if it differs from filePath;
+    // the file is renamed before being rewritten
+    void write(int promptId, const QString &filePath, const QString &previousPath, const QByteArray &data);
+    void remove(int promptId, const QString &filePath);
+    // Writes the vault's index snapshot after every job queued before it, so entries
+    // whose size is still unknown (-1) can be filled in from their files, which by
+    // then are written. A snapshot still waiting is dropped for the newer one.
+    void writeSnapshot(const QString &filePath, const QString &rootPath, const PromptIndexSnapshot::Contents &contents);
+
+    // Folder directories, in order with the saves around them. A rename fails rather
+    // than replace an existing directory; removal takes everything inside along.
+    void makeDirectory(const QString &path);
+    void renameDirectory(const QString &path, const QString &newPath);
+    void removeDirectory(const QString &path);
+
+    // Blocks until every job queued so far has been carried out
+    void flush();
+
+    // True while a queued or running job will touch the path, or for a directory job,
+    // anything inside it
+    bool isPending(const QString &filePath) const;
+    // True while any job is queued or running
+    bool isBusy() const;
+
+signals:
+    // Emitted from the writer thread; promptId is -1 for a snapshot or a directory
+    void fileWritten(int promptId, const QString &filePath, qint64 size, qint64 modifiedMs);
+    void writeFailed(int promptId, const QString &filePath, const QString &error);
+    // A directory job succeeded: path was created or removed, or previousPath moved to it
+    void directoryChanged(const QString &path, const QString &previousPath);
+    // The last queued job is done
+    void idle();
+
+protected:
+    void run() override;
+
+private:
+    enum class JobKind { Write, Remove, Snapshot, MakeDirectory, RenameDirectory, RemoveDirectory };
+    struct Job {
+        JobKind kind = JobKind::Write;
+        int promptId = -1;
+        QString filePath;       // or directory
+        QString previousPath;
+        QByteArray data;
+        QString rootPath;                       // snapshots: what entry paths are relative to
+        PromptIndexSnapshot::Contents contents; // snapshots
+    };
+
+    void enqueue(Job job);
+    bool process(Job &job, QString *error);
+    static bool touches(const Job &job, const QString &filePath);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QWaitCondition m_idle;
+    QList<quint64> m_order;           // job keys, in the order the jobs were queued
+    QHash<quint64, Job> m_jobs;
+    QHash<int, quint64> m_promptJobs; // prompt ID -> key of its waiting job
+    quint64 m_snapshotJob = 0;        // key of the waiting snapshot, 0 if none
+    quint64 m_nextKey = 1;
+    Job m_current;
+    bool m_busy = false;
+    bool m_stopping = false;
+};
+
+#endif // PROMPTFILEWRITER_H
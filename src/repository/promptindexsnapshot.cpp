@@ -0,0 +1,282 @@
+#include "promptindexsnapshot.h"
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const quint32 SnapshotMagic = 0x58494D50; // "PMIX"
+const quint32 SnapshotVersion = 2;
+const qint64 InvalidTime = std::numeric_limits<qint64>::min();
+
+qint64 toStoredTime(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : InvalidTime;
+}
+
+QDateTime fromStoredTime(qint64 msecs)
+{
+    return msecs == InvalidTime ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs);
+}
+
+} // namespace
+
+struct PromptIndexSnapshot::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    quint32 folderCount;
+    quint64 stringCount; // UTF-16 code units in the string table
+    qint32 nextPromptId;
+    qint32 nextFolderId;
+};
+
+struct PromptIndexSnapshot::RawEntry {
+    quint32 pathOffset;
+    quint32 pathLength;
+    quint32 titleOffset;
+    quint32 titleLength;
+    qint32 id;
+    quint32 reserved;
+    qint64 size;
+    qint64 modifiedMs;
+    qint64 createdAtMs;
+    qint64 updatedAtMs;
+    quint64 hash;
+};
+
+struct PromptIndexSnapshot::RawFolderEntry {
+    quint32 nameOffset;
+    quint32 nameLength;
+    qint32 id;
+    quint32 reserved;
+};
+
+PromptIndexSnapshot::~PromptIndexSnapshot()
+{
+    close();
+}
+
+bool PromptIndexSnapshot::open(const QString &filePath)
+{
+    static_assert(sizeof(Header) == 32, "snapshot header must not be padded");
+    static_assert(sizeof(RawEntry) == 64, "snapshot entry must not be padded");
+    static_assert(sizeof(RawFolderEntry) == 16, "snapshot folder entry must not be padded");
+
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(Header))) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(m_data);
+    const qint64 tableEnd = qint64(sizeof(Header)) + qint64(header->entryCount) * qint64(sizeof(RawEntry))
+                            + qint64(header->folderCount) * qint64(sizeof(RawFolderEntry));
+    if (header->magic != SnapshotMagic || header->version != SnapshotVersion
+        || tableEnd > m_size || header->stringCount > quint64(m_size)
+        || tableEnd + qint64(header->stringCount) * 2 != m_size) {
+        close();
+        return false;
+    }
+
+    m_count = header->entryCount;
+    m_strings = reinterpret_cast<const char16_t *>(m_data + tableEnd);
+    m_stringCount = header->stringCount;
+    return true;
+}
+
+void PromptIndexSnapshot::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_strings = nullptr;
+    m_stringCount = 0;
+}
+
+int PromptIndexSnapshot::count() const
+{
+    return int(m_count);
+}
+
+const PromptIndexSnapshot::Header *PromptIndexSnapshot::header() const
+{
+    return reinterpret_cast<const Header *>(m_data);
+}
+
+const PromptIndexSnapshot::RawEntry *PromptIndexSnapshot::entries() const
+{
+    return reinterpret_cast<const RawEntry *>(m_data + sizeof(Header));
+}
+
+QStringView PromptIndexSnapshot::string(quint32 offset, quint32 length) const
+{
+    if (quint64(offset) + length > m_stringCount) {
+        return QStringView();
+    }
+    return QStringView(m_strings + offset, qsizetype(length));
+}
+
+bool PromptIndexSnapshot::find(QStringView relativePath, Entry *entry) const
+{
+    if (!m_data) {
+        return false;
+    }
+
+    const RawEntry *begin = entries();
+    const RawEntry *end = begin + m_count;
+    const RawEntry *it = std::lower_bound(begin, end, relativePath,
+                                          [this](const RawEntry &raw, QStringView key) {
+        return string(raw.pathOffset, raw.pathLength).compare(key) < 0;
+    });
+    if (it == end || string(it->pathOffset, it->pathLength) != relativePath) {
+        return false;
+    }
+
+    if (entry) {
+        *entry = decode(*it);
+    }
+    return true;
+}
+
+PromptIndexSnapshot::Entry PromptIndexSnapshot::entryAt(int index) const
+{
+    if (!m_data || index < 0 || quint32(index) >= m_count) {
+        return Entry();
+    }
+    return decode(entries()[index]);
+}
+
+PromptIndexSnapshot::Entry PromptIndexSnapshot::decode(const RawEntry &raw) const
+{
+    Entry entry;
+    entry.relativePath = string(raw.pathOffset, raw.pathLength).toString();
+    entry.id = raw.id;
+    entry.size = raw.size;
+    entry.modifiedMs = raw.modifiedMs;
+    entry.hash = raw.hash;
+    entry.title = string(raw.titleOffset, raw.titleLength).toString();
+    entry.createdAt = fromStoredTime(raw.createdAtMs);
+    entry.updatedAt = fromStoredTime(raw.updatedAtMs);
+    return entry;
+}
+
+QList<PromptIndexSnapshot::FolderEntry> PromptIndexSnapshot::folders() const
+{
+    QList<FolderEntry> result;
+    if (!m_data) {
+        return result;
+    }
+
+    const RawFolderEntry *raw = reinterpret_cast<const RawFolderEntry *>(entries() + m_count);
+    const quint32 folderCount = header()->folderCount;
+    result.reserve(folderCount);
+    for (quint32 i = 0; i < folderCount; ++i) {
+        FolderEntry folder;
+        folder.name = string(raw[i].nameOffset, raw[i].nameLength).toString();
+        folder.id = raw[i].id;
+        result.append(folder);
+    }
+    return result;
+}
+
+int PromptIndexSnapshot::nextPromptId() const
+{
+    return m_data ? header()->nextPromptId : 1;
+}
+
+int PromptIndexSnapshot::nextFolderId() const
+{
+    return m_data ? header()->nextFolderId : 1;
+}
+
+bool PromptIndexSnapshot::write(const QString &filePath, Contents contents)
+{
+    QList<Entry> &entries = contents.entries;
+
+    // Same ordering as QStringView::compare(), which find() searches with
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.relativePath < b.relativePath;
+    });
+
+    QString strings;
+    QList<RawEntry> rawEntries;
+    rawEntries.reserve(entries.size());
+    for (const Entry &entry : std::as_const(entries)) {
+        RawEntry raw{};
+        raw.pathOffset = quint32(strings.size());
+        raw.pathLength = quint32(entry.relativePath.size());
+        strings += entry.relativePath;
+        raw.titleOffset = quint32(strings.size());
+        raw.titleLength = quint32(entry.title.size());
+        strings += entry.title;
+        raw.id = entry.id;
+        raw.size = entry.size;
+        raw.modifiedMs = entry.modifiedMs;
+        raw.createdAtMs = toStoredTime(entry.createdAt);
+        raw.updatedAtMs = toStoredTime(entry.updatedAt);
+        raw.hash = entry.hash;
+        rawEntries.append(raw);
+    }
+
+    QList<RawFolderEntry> rawFolders;
+    rawFolders.reserve(contents.folders.size());
+    for (const FolderEntry &folder : std::as_const(contents.folders)) {
+        RawFolderEntry raw{};
+        raw.nameOffset = quint32(strings.size());
+        raw.nameLength = quint32(folder.name.size());
+        strings += folder.name;
+        raw.id = folder.id;
+        rawFolders.append(raw);
+    }
+
+    Header header{};
+    header.magic = SnapshotMagic;
+    header.version = SnapshotVersion;
+    header.entryCount = quint32(rawEntries.size());
+    header.folderCount = quint32(rawFolders.size());
+    header.stringCount = quint64(strings.size());
+    header.nextPromptId = contents.nextPromptId;
+    header.nextFolderId = contents.nextFolderId;
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(rawEntries.constData()), qint64(rawEntries.size()) * qint64(sizeof(RawEntry)));
+    file.write(reinterpret_cast<const char *>(rawFolders.constData()), qint64(rawFolders.size()) * qint64(sizeof(RawFolderEntry)));
+    file.write(reinterpret_cast<const char *>(strings.constData()), qint64(strings.size()) * 2);
+    return file.commit();
+}
+
+QString PromptIndexSnapshot::defaultLocation(const QString &rootPath)
+{
+    // One snapshot per vault, outside the vault so sync tools never see it
+    const QString absoluteRoot = QDir::cleanPath(QDir(rootPath).absolutePath());
+    const QByteArray key = QCryptographicHash::hash(absoluteRoot.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + "/index/" + QString::fromLatin1(key) + ".idx";
+}
@@ -0,0 +1,95 @@
+#ifndef PROMPTINDEXSNAPSHOT_H
+#define PROMPTINDEXSNAPSHOT_H
+
+#include <QString>
+#include <QStringView>
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+
+// On-disk index of a markdown vault, written after a scan and memory-mapped on the
+// next start so unchanged files don't have to be opened again.
+//
+// It also persists the prompt and folder IDs handed out for the vault, so they stay
+// the same across reloads and restarts.
+//
+// An entry is trusted as long as its file's size and modification time are unchanged;
+// the file is not read to check. The hash covers only the front matter, which is all
+// an entry caches, and is used to recognise renamed files. Hashing bodies would mean
+// reading every file on startup, which is what the snapshot exists to avoid. An edit
+// that keeps both the size and the mtime therefore goes unnoticed until the file
+// changes again.
+//
+// Layout (native byte order, it never leaves the machine):
+//   Header | Entry[entryCount] sorted by path | FolderEntry[folderCount] | UTF-16 string table
+// Entries reference their path and title by offset into the string table, so a
+// lookup is a binary search over the mapped file with no decoding.
+class PromptIndexSnapshot
+{
+public:
+    struct Entry {
+        QString relativePath;   // relative to the vault root, '/' separated
+        int id = -1;
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+        quint64 hash = 0;       // hash of the front matter, see MarkdownPromptRepository
+        QString title;
+        QDateTime createdAt;
+        QDateTime updatedAt;
+    };
+
+    struct FolderEntry {
+        QString name;
+        int id = -1;
+    };
+
+    // Everything write() needs; IDs below the counters are never handed out again
+    struct Contents {
+        QList<Entry> entries;
+        QList<FolderEntry> folders;
+        int nextPromptId = 1;
+        int nextFolderId = 1;
+    };
+
+    PromptIndexSnapshot() = default;
+    ~PromptIndexSnapshot();
+
+    PromptIndexSnapshot(const PromptIndexSnapshot &) = delete;
+    PromptIndexSnapshot &operator=(const PromptIndexSnapshot &) = delete;
+
+    // Maps the snapshot; returns false if it is missing, truncated or of another version
+    bool open(const QString &filePath);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    int count() const;
+
+    // Safe to call from several threads once open() has returned
+    bool find(QStringView relativePath, Entry *entry) const;
+    Entry entryAt(int index) const;
+
+    QList<FolderEntry> folders() const;
+    int nextPromptId() const;
+    int nextFolderId() const;
+
+    static bool write(const QString &filePath, Contents contents);
+    static QString defaultLocation(const QString &rootPath);
+
+private:
+    struct Header;
+    struct RawEntry;
+    struct RawFolderEntry;
+
+    const Header *header() const;
+    const RawEntry *entries() const;
+    Entry decode(const RawEntry &raw) const;
+    QStringView string(quint32 offset, quint32 length) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    quint32 m_count = 0;
+    const char16_t *m_strings = nullptr;
+    quint64 m_stringCount = 0;
+};
+
+#endif // PROMPTINDEXSNAPSHOT_H
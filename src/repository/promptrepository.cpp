@@ -1,10 +1,203 @@
 #include "promptrepository.h"
+#include "../utils/regexcache.h"
+#include <QThreadPool>
+#include <QDebug>
 
 PromptRepository::PromptRepository(QObject *parent)
-    : QObject(parent)
+    : QObject(parent), m_generation(0), m_searchIndexValid(false)
 {
+    // Connected before anyone else, so listeners already see the new generation
+    const auto bump = [this]() { ++m_generation; };
+    connect(this, &PromptRepository::promptAdded, this, bump);
+    connect(this, &PromptRepository::promptUpdated, this, bump);
+    connect(this, &PromptRepository::promptDeleted, this, bump);
+    connect(this, &PromptRepository::folderAdded, this, bump);
+    connect(this, &PromptRepository::folderUpdated, this, bump);
+    connect(this, &PromptRepository::folderDeleted, this, bump);
+    connect(this, &PromptRepository::dataChanged, this, bump);
+
+    // Folder changes leave records as they are; folder: terms resolve at parse time
+    connect(this, &PromptRepository::promptAdded, this, &PromptRepository::indexPrompt);
+    connect(this, &PromptRepository::promptUpdated, this, &PromptRepository::indexPrompt);
+    connect(this, &PromptRepository::promptDeleted, this, &PromptRepository::unindexPrompt);
+    connect(this, &PromptRepository::dataChanged, this, [this]() { m_searchIndexValid = false; });
 }
 
 PromptRepository::~PromptRepository()
 {
-}
\ No newline at end of file
+}
+
+QString PromptRepository::getPromptContent(int promptId)
+{
+    Prompt *prompt = getPromptById(promptId);
+    if (!prompt) {
+        return QString();
+    }
+
+    QString content = prompt->content();
+    delete prompt;
+    return content;
+}
+
+PromptRecord PromptRepository::promptRecordById(int promptId)
+{
+    Prompt *prompt = getPromptById(promptId);
+    if (!prompt) {
+        return PromptRecord();
+    }
+
+    PromptRecord record(prompt);
+    delete prompt;
+    return record;
+}
+
+QList<PromptRecord> PromptRepository::allPromptRecords()
+{
+    return takeRecords(getAllPrompts());
+}
+
+QList<PromptRecord> PromptRepository::promptRecordsByFolder(int folderId)
+{
+    return takeRecords(getPromptsByFolder(folderId));
+}
+
+QList<PromptRecord> PromptRepository::promptRecordsWithoutFolder()
+{
+    return takeRecords(getPromptsWithoutFolder());
+}
+
+QList<PromptRecord> PromptRepository::searchPromptRecords(const QString &searchText)
+{
+    return searchIndex().search(parseSearchQuery(searchText));
+}
+
+QList<PromptRecord> PromptRepository::searchPromptRecordsInFolder(const QString &searchText, int folderId)
+{
+    return searchIndex().search(parseSearchQuery(searchText, folderId));
+}
+
+QList<PromptRecord> PromptRepository::rankPromptRecords(const QString &searchText, int limit)
+{
+    return searchIndex().rank(parseSearchQuery(searchText), limit);
+}
+
+QList<PromptRecord> PromptRepository::rankPromptRecordsInFolder(const QString &searchText, int folderId, int limit)
+{
+    return searchIndex().rank(parseSearchQuery(searchText, folderId), limit);
+}
+
+QList<PromptSearchIndex::RegexHit> PromptRepository::regexSearchPromptRecords(const QString &pattern, int folderId,
+                                                                                int timeoutMs, bool *timedOut,
+                                                                                QString *error)
+{
+    const QRegularExpression regex = RegexCache::compile(pattern);
+    if (!regex.isValid()) {
+        qWarning() << "Invalid search pattern" << pattern << ":" << regex.errorString();
+        if (error) {
+            *error = regex.errorString();
+        }
+        if (timedOut) {
+            *timedOut = false;
+        }
+        return QList<PromptSearchIndex::RegexHit>();
+    }
+    return searchIndex().matchRegex(regex, folderId, QThreadPool::globalInstance(), QDeadlineTimer(timeoutMs),
+                                    timedOut);
+}
+
+int PromptRepository::folderIdByName(const QString &name)
+{
+    const QList<Folder*> folders = getAllFolders();
+    int folderId = -1;
+    for (Folder *folder : folders) {
+        if (folder->name().compare(name, Qt::CaseInsensitive) == 0) {
+            folderId = folder->id();
+            break;
+        }
+    }
+    qDeleteAll(folders);
+    return folderId;
+}
+
+SearchQuery PromptRepository::parseSearchQuery(const QString &searchText, int folderId)
+{
+    SearchQuery query = SearchQuery::parse(searchText, [this](const QString &name) {
+        return folderIdByName(name);
+    });
+    if (folderId > 0) {
+        query.restrictToFolder(folderId);
+    }
+    return query;
+}
+
+// Built on first use and after a bulk change; between those the change signals patch
+// it one prompt at a time, so every search shares the same index
+PromptSearchIndex PromptRepository::searchIndex()
+{
+    if (m_searchIndexValid) {
+        return m_searchIndex;
+    }
+
+    QList<PromptRecord> records = allPromptRecords();
+    QList<int> order;
+    order.reserve(records.size());
+    for (int i = 0; i < records.size(); ++i) {
+        const PromptRecord record = records.at(i);
+        if (!record.isContentLoaded()) {
+            records[i] = PromptRecord(record.id(), record.title(), getPromptContent(record.id()), record.folderId(),
+                                      record.createdAt(), record.updatedAt());
+        }
+        order.append(record.id());
+    }
+
+    m_searchIndex.clear();
+    m_searchIndex.update(records, QThreadPool::globalInstance());
+    m_searchIndex.setOrder(order);
+    m_searchIndexValid = true;
+    return m_searchIndex;
+}
+
+bool PromptRepository::prepareSearchIndex()
+{
+    return true;
+}
+
+// A new or edited prompt leads the listing, as it does in listings sorted by last
+// change; one only moved to another folder keeps its place
+void PromptRepository::indexPrompt(const Prompt *prompt)
+{
+    if (!m_searchIndexValid) {
+        return;
+    }
+
+    PromptRecord record(prompt);
+    if (!record.isContentLoaded()) {
+        record = PromptRecord(record.id(), record.title(), getPromptContent(record.id()), record.folderId(),
+                              record.createdAt(), record.updatedAt());
+    }
+    const PromptRecord previous = m_searchIndex.record(record.id());
+    m_searchIndex.update({record});
+    if (!previous.isValid() || previous.updatedAt() != record.updatedAt()) {
+        m_searchIndex.removeFromOrder(record.id());
+        m_searchIndex.prependToOrder(record.id());
+    }
+}
+
+void PromptRepository::unindexPrompt(int promptId)
+{
+    if (m_searchIndexValid) {
+        m_searchIndex.remove(promptId);
+        m_searchIndex.removeFromOrder(promptId);
+    }
+}
+
+QList<PromptRecord> PromptRepository::takeRecords(const QList<Prompt*> &prompts)
+{
+    QList<PromptRecord> records;
+    records.reserve(prompts.size());
+    for (Prompt *prompt : prompts) {
+        records.append(PromptRecord(prompt));
+    }
+    qDeleteAll(prompts);
+    return records;
+}
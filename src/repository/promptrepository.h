@@ -6,6 +6,8 @@
 #include "../models/prompt.h"
 #include "../models/folder.h"
 #include "../models/promptwithfolder.h"
+#include "../models/promptrecord.h"
+#include "promptsearchindex.h"
 
 class PromptRepository : public QObject
 {
@@ -23,6 +25,51 @@ public:
     virtual QList<Prompt*> getPromptsByFolder(int folderId) = 0;
     virtual QList<Prompt*> getPromptsWithoutFolder() = 0;
     virtual bool duplicatePrompt(int promptId) = 0;
+
+    // Body of a prompt whose content was returned unloaded (see Prompt::isContentLoaded)
+    virtual QString getPromptContent(int promptId);
+
+    // Read-only snapshots. Nothing to delete; the defaults convert the Prompt* API
+    // (searches go through searchIndex()), repositories that keep a cache override
+    // them to share it instead.
+    virtual PromptRecord promptRecordById(int promptId);
+    virtual QList<PromptRecord> allPromptRecords();
+    virtual QList<PromptRecord> promptRecordsByFolder(int folderId);
+    virtual QList<PromptRecord> promptRecordsWithoutFolder();
+    virtual QList<PromptRecord> searchPromptRecords(const QString &searchText);
+    virtual QList<PromptRecord> searchPromptRecordsInFolder(const QString &searchText, int folderId);
+
+    // Ranked search: at most limit prompts sharing a word with the query, most relevant
+    // first (BM25 over title and body)
+    virtual QList<PromptRecord> rankPromptRecords(const QString &searchText, int limit);
+    virtual QList<PromptRecord> rankPromptRecordsInFolder(const QString &searchText, int folderId, int limit);
+
+    // Regex search over prompt bodies (pattern syntax as QRegularExpression,
+    // case-insensitive); folderId > 0 restricts it to that folder. Compiled patterns
+    // are cached (see RegexCache). Matching stops after timeoutMs with *timedOut set
+    // and what was found so far; an invalid pattern sets *error and matches nothing.
+    QList<PromptSearchIndex::RegexHit> regexSearchPromptRecords(const QString &pattern, int folderId, int timeoutMs,
+                                                                bool *timedOut = nullptr, QString *error = nullptr);
+
+    // Copy of the search state that can be queried from any thread. The default
+    // builds one from allPromptRecords() once and patches it from the change signals
+    // below; repositories that keep a cache maintain their own.
+    virtual PromptSearchIndex searchIndex();
+    // Whether searchIndex() can return without reading or indexing anything on the
+    // calling thread. Repositories that do that work in the background start it here
+    // if needed, return false and emit searchIndexReady() once it is done; the GUI
+    // thread checks this rather than block in searchIndex().
+    virtual bool prepareSearchIndex();
+
+    // Bumped by every change signal below, so anything derived from the repository's
+    // contents can be checked for staleness by comparing one number
+    quint64 generation() const { return m_generation; }
+
+    // Compiles search box text (see SearchQuery), resolving folder: names against
+    // this repository; folderId > 0 additionally restricts it to that folder
+    SearchQuery parseSearchQuery(const QString &searchText, int folderId = -1);
+    // Case-insensitive; -1 if there is no such folder
+    virtual int folderIdByName(const QString &name);
     
     // Folder operations
     virtual bool saveFolder(Folder *folder) = 0;
@@ -42,16 +89,33 @@ public:
     // Statistics
     virtual int getPromptCount() = 0;
     virtual int getFolderCount() = 0;
-    virtual int getPromptCountByFolder(int folderId) = 0;
+    virtual int getPromptCountByFolder(int folderId) = 0; // folderId < 1: uncategorized
 
 signals:
+    // Granular changes. Objects passed along are only valid during the emission;
+    // deleting a folder reports its prompts' removal first.
     void promptAdded(Prompt *prompt);
     void promptUpdated(Prompt *prompt);
     void promptDeleted(int promptId);
     void folderAdded(Folder *folder);
     void folderUpdated(Folder *folder);
     void folderDeleted(int folderId);
+    // Bulk change (reload, or a change with no granular signal): re-read everything
     void dataChanged();
+    // Background indexing caught up; see prepareSearchIndex()
+    void searchIndexReady();
+
+protected:
+    // Converts and deletes the prompts
+    static QList<PromptRecord> takeRecords(const QList<Prompt*> &prompts);
+
+private:
+    void indexPrompt(const Prompt *prompt);
+    void unindexPrompt(int promptId);
+
+    quint64 m_generation;
+    PromptSearchIndex m_searchIndex;
+    bool m_searchIndexValid;
 };
 
 #endif // PROMPTREPOSITORY_H
\ No newline at end of file
@@ -0,0 +1,580 @@
+#include "promptsearchindex.h"
+#include "../utils/textfolding.h"
+#include "../utils/placeholderutils.h"
+#include <QThreadPool>
+#include <QSet>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <iterator>
+#include <atomic>
+#include <limits>
+
+namespace {
+
+// How many candidates are verified between two cancellation checks
+constexpr int kCancelCheckInterval = 256;
+
+// Result batches start at about a screenful and grow, so a huge result set
+// doesn't turn into thousands of tiny model inserts
+constexpr int kFirstBatchSize = 32;
+constexpr int kMaxBatchSize = 2048;
+
+// Verifying a candidate is a substring search in its folded text, cheap enough that
+// smaller sets aren't worth splitting. Above the threshold candidates are verified on
+// the pool in chunks, a wave of one chunk per thread at a time, so results still
+// arrive in order and a cancelled search stops after the current wave.
+constexpr int kParallelThreshold = 4096;
+constexpr int kParallelChunkSize = 1024;
+
+// Regex matching costs far more per prompt than a substring search, so it pays to
+// go parallel much earlier
+constexpr int kRegexParallelThreshold = 256;
+// Match offsets kept per prompt; enough to highlight, bounded for patterns like "."
+constexpr int kMaxRegexSpans = 32;
+
+struct IndexTerms {
+    QString folded;
+    QList<TrigramIndex::Trigram> trigrams;
+    Bm25Index::Document document;
+    bool hasPlaceholders = false;
+};
+
+IndexTerms indexTerms(const PromptRecord &record)
+{
+    IndexTerms terms;
+    terms.folded = TextFolding::fold(record.title() + QLatin1Char('\n') + record.content());
+    terms.trigrams = TrigramIndex::trigrams(terms.folded);
+    terms.document = Bm25Index::analyze(record.title(), record.content());
+    terms.hasPlaceholders = PlaceholderUtils::hasPlaceholders(record.content());
+    return terms;
+}
+
+// Shared by all indexes, so two of them never report the same generation
+std::atomic<quint64> nextGeneration{1};
+
+} // namespace
+
+void PromptSearchIndex::touch()
+{
+    m_generation = nextGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PromptSearchIndex::update(const QList<PromptRecord> &records, QThreadPool *pool)
+{
+    if (records.isEmpty()) {
+        return;
+    }
+    touch();
+
+    QList<PromptRecord> indexed;
+    QList<int> ids;
+    for (const PromptRecord &record : records) {
+        remove(record.id());
+        if (record.isContentLoaded()) {
+            indexed.append(record);
+            ids.append(record.id());
+        }
+    }
+    if (indexed.isEmpty()) {
+        return;
+    }
+
+    // Folding and tokenizing are the expensive part; a single edit isn't worth a round
+    // trip to the pool
+    QList<IndexTerms> terms;
+    if (pool && indexed.size() > 1) {
+        terms = QtConcurrent::blockingMapped<QList<IndexTerms>>(pool, indexed, indexTerms);
+    } else {
+        for (const PromptRecord &record : std::as_const(indexed)) {
+            terms.append(indexTerms(record));
+        }
+    }
+
+    QList<QList<TrigramIndex::Trigram>> trigrams;
+    QList<Bm25Index::Document> documents;
+    trigrams.reserve(terms.size());
+    documents.reserve(terms.size());
+    for (int i = 0; i < terms.size(); ++i) {
+        IndexTerms &t = terms[i];
+        trigrams.append(std::move(t.trigrams));
+        documents.append(std::move(t.document));
+        m_entries.insert(ids.at(i), Entry{indexed.at(i), std::move(t.folded), t.hasPlaceholders});
+    }
+    m_trigrams.insertBatch(ids, trigrams);
+    m_ranking.insertBatch(ids, documents);
+}
+
+// The stored record is exactly what the prompt was indexed with, so its terms can be
+// recomputed instead of being kept around per prompt
+void PromptSearchIndex::remove(int promptId)
+{
+    auto it = m_entries.find(promptId);
+    if (it == m_entries.end()) {
+        return;
+    }
+    touch();
+    m_trigrams.remove(promptId, it->folded);
+    m_ranking.remove(promptId, Bm25Index::analyze(it->record.title(), it->record.content()));
+    m_entries.erase(it);
+}
+
+void PromptSearchIndex::clear()
+{
+    m_trigrams.clear();
+    m_ranking.clear();
+    m_entries.clear();
+    m_order.clear();
+    m_positions.clear();
+    m_orderStart = 0;
+    m_orderHoles = 0;
+    touch();
+}
+
+void PromptSearchIndex::setOrder(const QList<int> &promptIds)
+{
+    touch();
+    m_order = promptIds;
+    m_orderStart = 0;
+    m_orderHoles = 0;
+    m_positions.clear();
+    m_positions.reserve(promptIds.size());
+    for (int i = 0; i < promptIds.size(); ++i) {
+        m_positions.insert(promptIds.at(i), i);
+    }
+}
+
+void PromptSearchIndex::appendToOrder(int promptId)
+{
+    if (m_positions.contains(promptId)) {
+        return;
+    }
+    touch();
+    m_positions.insert(promptId, m_orderStart + int(m_order.size()));
+    m_order.append(promptId);
+}
+
+// Positions are only compared, so the ones already handed out stay valid below a
+// new first one
+void PromptSearchIndex::prependToOrder(int promptId)
+{
+    if (m_positions.contains(promptId)) {
+        return;
+    }
+    touch();
+    m_positions.insert(promptId, --m_orderStart);
+    m_order.prepend(promptId);
+}
+
+// Leaves a hole, which no index entry matches, so positions after it stay valid.
+// Holes are squeezed out once they outnumber the prompts.
+void PromptSearchIndex::removeFromOrder(int promptId)
+{
+    const auto it = m_positions.constFind(promptId);
+    if (it == m_positions.cend()) {
+        return;
+    }
+    touch();
+    m_order[it.value() - m_orderStart] = -1;
+    m_positions.erase(it);
+    if (++m_orderHoles > m_positions.size()) {
+        QList<int> order;
+        order.reserve(m_positions.size());
+        for (int id : std::as_const(m_order)) {
+            if (id != -1) {
+                order.append(id);
+            }
+        }
+        setOrder(order);
+    }
+}
+
+SearchQuery::Subject PromptSearchIndex::subject(const Entry &entry)
+{
+    SearchQuery::Subject subject;
+    subject.folderId = entry.record.folderId();
+    subject.createdAt = entry.record.createdAt();
+    subject.updatedAt = entry.record.updatedAt();
+    subject.foldedText = entry.folded;
+    subject.hasPlaceholders = entry.hasPlaceholders;
+    return subject;
+}
+
+// Prompt IDs worth evaluating the query on, in listing order. Each required word
+// narrows the set through the trigram index; ones shorter than a trigram can't, and
+// a query without any scans everything.
+QList<int> PromptSearchIndex::candidates(const SearchQuery &query) const
+{
+    bool narrowed = false;
+    QList<int> result;
+    const QStringList required = query.requiredText();
+    for (const QString &text : required) {
+        QList<int> ids;
+        if (!m_trigrams.candidates(text, &ids)) {
+            continue;
+        }
+        if (narrowed) {
+            QList<int> both;
+            std::set_intersection(result.cbegin(), result.cend(), ids.cbegin(), ids.cend(), std::back_inserter(both));
+            result.swap(both);
+        } else {
+            result.swap(ids);
+            narrowed = true;
+        }
+    }
+    if (!narrowed) {
+        return m_order;
+    }
+
+    std::sort(result.begin(), result.end(), [this](int a, int b) {
+        return m_positions.value(a, std::numeric_limits<int>::max()) <
+               m_positions.value(b, std::numeric_limits<int>::max());
+    });
+    return result;
+}
+
+QList<PromptRecord> PromptSearchIndex::search(const SearchQuery &query, const CancelCheck &cancelled) const
+{
+    QList<PromptRecord> result;
+    bool complete = true;
+    search(query, [&result](const QList<PromptRecord> &batch) {
+        result.append(batch);
+    }, [&]() {
+        complete = !(cancelled && cancelled());
+        return !complete;
+    });
+    return complete ? result : QList<PromptRecord>();
+}
+
+// Candidates are put in listing order before the query is evaluated on them, which is
+// the expensive part, so every batch can be shown as soon as it is complete
+void PromptSearchIndex::search(const SearchQuery &query, const ResultSink &sink, const CancelCheck &cancelled,
+                               QThreadPool *pool) const
+{
+    evaluate(query, candidates(query), sink, cancelled, pool);
+}
+
+void PromptSearchIndex::refine(const SearchQuery &query, const QList<int> &promptIds, const ResultSink &sink,
+                               const CancelCheck &cancelled, QThreadPool *pool) const
+{
+    evaluate(query, promptIds, sink, cancelled, pool);
+}
+
+QList<PromptRecord> PromptSearchIndex::matchRange(const SearchQuery &query, const QList<int> &ids, qsizetype begin,
+                                                  qsizetype end) const
+{
+    QList<PromptRecord> matches;
+    for (qsizetype i = begin; i < end; ++i) {
+        const auto it = m_entries.constFind(ids.at(i));
+        if (it == m_entries.constEnd()) {
+            continue; // not indexed, its body isn't loaded
+        }
+        if (query.matches(subject(it.value()))) {
+            matches.append(it->record);
+        }
+    }
+    return matches;
+}
+
+void PromptSearchIndex::evaluate(const SearchQuery &query, const QList<int> &ids, const ResultSink &sink,
+                                 const CancelCheck &cancelled, QThreadPool *pool) const
+{
+    QList<PromptRecord> batch;
+    int batchSize = kFirstBatchSize;
+    auto deliver = [&](const PromptRecord &record) {
+        batch.append(record);
+        if (batch.size() >= batchSize) {
+            sink(batch);
+            batch.clear();
+            batchSize = qMin(batchSize * 4, kMaxBatchSize);
+        }
+    };
+
+    if (!pool || ids.size() < kParallelThreshold) {
+        for (qsizetype i = 0; i < ids.size(); i += kCancelCheckInterval) {
+            if (i > 0 && cancelled && cancelled()) {
+                return;
+            }
+            for (const PromptRecord &record : matchRange(query, ids, i, qMin<qsizetype>(i + kCancelCheckInterval,
+                                                                                          ids.size()))) {
+                deliver(record);
+            }
+        }
+    } else {
+        const qsizetype wave = qsizetype(qMax(1, pool->maxThreadCount())) * kParallelChunkSize;
+        for (qsizetype waveStart = 0; waveStart < ids.size(); waveStart += wave) {
+            if (waveStart > 0 && cancelled && cancelled()) {
+                return;
+            }
+            QList<qsizetype> chunkStarts;
+            for (qsizetype start = waveStart; start < qMin(waveStart + wave, ids.size()); start += kParallelChunkSize) {
+                chunkStarts.append(start);
+            }
+            // blockingMapped() keeps the chunks in order and lets this thread take
+            // part, so it can't stall on a pool that is busy with this very search
+            const QList<QList<PromptRecord>> chunks = QtConcurrent::blockingMapped<QList<QList<PromptRecord>>>(
+                pool, chunkStarts, [&](qsizetype start) {
+                    return matchRange(query, ids, start, qMin<qsizetype>(start + kParallelChunkSize, ids.size()));
+                });
+            for (const QList<PromptRecord> &chunk : chunks) {
+                for (const PromptRecord &record : chunk) {
+                    deliver(record);
+                }
+            }
+        }
+    }
+    if (!batch.isEmpty()) {
+        sink(batch);
+    }
+}
+
+QList<PromptRecord> PromptSearchIndex::rank(const SearchQuery &query, int limit, const CancelCheck &cancelled) const
+{
+    const QString rankingText = query.rankingText();
+    if (rankingText.isEmpty()) {
+        return search(query, cancelled).mid(0, limit);
+    }
+
+    // Every hit shares a word with the query; the plan decides whether it matches
+    const auto filter = [this, &query](int promptId) {
+        const auto it = m_entries.constFind(promptId);
+        return it != m_entries.constEnd() && query.matches(subject(it.value()));
+    };
+    const QList<Bm25Index::Hit> hits = m_ranking.topK(rankingText, limit, filter);
+    if (cancelled && cancelled()) {
+        return QList<PromptRecord>();
+    }
+
+    QList<PromptRecord> result;
+    QSet<int> ranked;
+    result.reserve(hits.size());
+    for (const Bm25Index::Hit &hit : hits) {
+        result.append(m_entries.value(hit.docId).record);
+        ranked.insert(hit.docId);
+    }
+    if (result.size() >= limit) {
+        return result;
+    }
+
+    // BM25 only knows whole words (and a prefix of the last one), but the plan matches
+    // substrings: "script" finds "javascript" without sharing a word with it. Such
+    // matches come after every ranked one, in listing order, as if scored at a floor.
+    bool full = false;
+    evaluate(query, candidates(query), [&](const QList<PromptRecord> &batch) {
+        for (const PromptRecord &record : batch) {
+            if (!full && !ranked.contains(record.id())) {
+                result.append(record);
+                full = result.size() >= limit;
+            }
+        }
+    }, [&]() { return full || (cancelled && cancelled()); }, nullptr);
+    if (!full && cancelled && cancelled()) {
+        return QList<PromptRecord>();
+    }
+    return result;
+}
+
+QList<PromptSearchIndex::RegexHit> PromptSearchIndex::matchRegex(const QRegularExpression &pattern, int folderId,
+                                                                 QThreadPool *pool, const QDeadlineTimer &deadline,
+                                                                 bool *timedOut, const CancelCheck &cancelled) const
+{
+    if (timedOut) {
+        *timedOut = false;
+    }
+    if (!pattern.isValid()) {
+        return QList<RegexHit>();
+    }
+
+    // Set by whichever chunk notices first, stopping the others as well
+    std::atomic<bool> expired{false};
+    std::atomic<bool> abandoned{false};
+
+    auto matchRange = [&](qsizetype begin, qsizetype end) {
+        QList<RegexHit> hits;
+        for (qsizetype i = begin; i < end; ++i) {
+            if (expired.load(std::memory_order_relaxed) || abandoned.load(std::memory_order_relaxed)) {
+                break;
+            }
+            if (deadline.hasExpired()) {
+                expired = true;
+                break;
+            }
+            if (cancelled && (i - begin) % kCancelCheckInterval == 0 && cancelled()) {
+                abandoned = true;
+                break;
+            }
+
+            const auto it = m_entries.constFind(m_order.at(i));
+            if (it == m_entries.cend() || (folderId > 0 && it->record.folderId() != folderId)) {
+                continue;
+            }
+
+            bool matched = false;
+            QList<Span> spans = locate(pattern, it->record.content(), kMaxRegexSpans, &matched, deadline);
+            if (matched) {
+                hits.append(RegexHit{it->record, std::move(spans)});
+            }
+            if (deadline.hasExpired()) {
+                expired = true;
+                break;
+            }
+        }
+        return hits;
+    };
+
+    QList<RegexHit> result;
+    if (!pool || m_order.size() < kRegexParallelThreshold) {
+        result = matchRange(0, m_order.size());
+    } else {
+        // Contiguous chunks, concatenated in order, keep the listing order
+        const qsizetype chunkCount = qMax(1, pool->maxThreadCount() * 4);
+        const qsizetype chunkSize = (m_order.size() + chunkCount - 1) / chunkCount;
+        QList<qsizetype> chunkStarts;
+        for (qsizetype start = 0; start < m_order.size(); start += chunkSize) {
+            chunkStarts.append(start);
+        }
+        const QList<QList<RegexHit>> chunks = QtConcurrent::blockingMapped<QList<QList<RegexHit>>>(
+            pool, chunkStarts, [&](qsizetype start) { return matchRange(start, qMin(start + chunkSize, m_order.size())); });
+        for (const QList<RegexHit> &chunk : chunks) {
+            result.append(chunk);
+        }
+    }
+
+    if (timedOut) {
+        *timedOut = expired;
+    }
+    return result;
+}
+
+QList<PromptSearchIndex::Span> PromptSearchIndex::locate(const SearchQuery &query, const QString &body, int max)
+{
+    const QStringList terms = query.requiredText();
+    QList<Span> spans;
+    if (terms.isEmpty() || body.isEmpty()) {
+        return spans;
+    }
+
+    // Terms are matched in folded text, so offsets are mapped back through the fold
+    QList<int> sources;
+    const QString folded = TextFolding::fold(body, &sources);
+    for (const QString &term : terms) {
+        const TextFolding::Matcher matcher(term);
+        const qsizetype length = matcher.needle().size();
+        if (length == 0) {
+            continue;
+        }
+        int found = 0;
+        for (qsizetype at = matcher.indexIn(folded); at != -1 && found < max;
+             at = matcher.indexIn(folded, at + length)) {
+            // The match ends where the next source character starts, taking along
+            // any marks folding dropped
+            const int last = sources.at(at + length - 1);
+            qsizetype next = at + length;
+            while (sources.at(next) == last) {
+                ++next;
+            }
+            spans.append(Span{sources.at(at), sources.at(next) - sources.at(at)});
+            ++found;
+        }
+    }
+
+    // Merge overlapping matches of different terms into one span each
+    std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) { return a.start < b.start; });
+    QList<Span> merged;
+    for (const Span &span : std::as_const(spans)) {
+        if (!merged.isEmpty() && span.start <= merged.last().start + merged.last().length) {
+            Span &previous = merged.last();
+            previous.length = qMax(previous.start + previous.length, span.start + span.length) - previous.start;
+        } else if (merged.size() < max) {
+            merged.append(span);
+        }
+    }
+    return merged;
+}
+
+QList<PromptSearchIndex::Span> PromptSearchIndex::locate(const QRegularExpression &pattern, const QString &body,
+                                                         int max, bool *matched, const QDeadlineTimer &deadline)
+{
+    QList<Span> spans;
+    bool any = false;
+    QRegularExpressionMatchIterator match = pattern.globalMatch(body);
+    // Empty matches count towards max as well, or "x*" would step through every
+    // position of a long body
+    for (int found = 0; found < max && !deadline.hasExpired() && match.hasNext(); ++found) {
+        const QRegularExpressionMatch m = match.next();
+        any = true;
+        // Empty matches (e.g. "^") select the prompt but have nothing to highlight
+        if (m.capturedLength() > 0) {
+            spans.append(Span{int(m.capturedStart()), int(m.capturedLength())});
+        }
+    }
+    if (matched) {
+        *matched = any;
+    }
+    return spans;
+}
+
+PromptSearchIndex::Snippet PromptSearchIndex::snippet(const QString &body, const QList<Span> &matches, int length)
+{
+    Snippet result;
+    if (matches.isEmpty() || length <= 0) {
+        return result;
+    }
+
+    // The window starting at the match that is followed by the most others within it
+    int best = 0;
+    int bestCount = 0;
+    for (int i = 0; i < matches.size(); ++i) {
+        int count = 0;
+        for (int j = i; j < matches.size() && matches.at(j).start + matches.at(j).length <= matches.at(i).start + length;
+             ++j) {
+            ++count;
+        }
+        if (count > bestCount) {
+            best = i;
+            bestCount = count;
+        }
+    }
+
+    // Some context before the match, then back up to the start of that word
+    constexpr int kMaxWordScan = 20;
+    int start = qMax(0, matches.at(best).start - length / 4);
+    for (int k = 0; start > 0 && k < kMaxWordScan && !body.at(start - 1).isSpace(); ++k) {
+        --start;
+    }
+    int end = qMin<int>(body.size(), start + length);
+    if (end < body.size()) {
+        // Don't cut a word in half unless it is very long
+        int cut = end;
+        for (int k = 0; cut > start && k < kMaxWordScan && !body.at(cut).isSpace(); ++k) {
+            --cut;
+        }
+        if (cut > start && body.at(cut).isSpace()) {
+            end = cut;
+        }
+    }
+
+    const QChar ellipsis(0x2026);
+    const int offset = start > 0 ? 1 : 0;
+    if (offset) {
+        result.text.append(ellipsis);
+    }
+    // Replaced one for one, so highlight offsets stay valid
+    for (int i = start; i < end; ++i) {
+        const QChar c = body.at(i);
+        result.text.append(c == QLatin1Char('\n') || c == QLatin1Char('\r') || c == QLatin1Char('\t')
+                               ? QChar(QLatin1Char(' '))
+                               : c);
+    }
+    if (end < body.size()) {
+        result.text.append(ellipsis);
+    }
+
+    for (const Span &span : matches) {
+        const int from = qMax(span.start, start);
+        const int to = qMin(span.start + span.length, end);
+        if (from < to) {
+            result.highlights.append(Span{from - start + offset, to - from});
+        }
+    }
+    return result;
+}
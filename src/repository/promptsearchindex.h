@@ -0,0 +1,132 @@
+#ifndef PROMPTSEARCHINDEX_H
+#define PROMPTSEARCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QRegularExpression>
+#include <QDeadlineTimer>
+#include <functional>
+#include "../models/promptrecord.h"
+#include "../utils/trigramindex.h"
+#include "../utils/bm25index.h"
+#include "../utils/searchquery.h"
+
+class QThreadPool;
+
+// Searchable copy of a repository's prompts: the records with their folded text, a
+// trigram index for substring search and a BM25 index for ranking. It is a value type
+// made of implicitly shared containers, so a copy costs next to nothing and can be
+// queried on a worker thread while the repository keeps updating its own.
+class PromptSearchIndex
+{
+public:
+    // Polled by long-running queries; returning true abandons the query
+    using CancelCheck = std::function<bool()>;
+    // Receives matches in result order, a batch at a time, as they are found
+    using ResultSink = std::function<void(const QList<PromptRecord> &)>;
+
+    // Characters [start, start + length) of a prompt's body
+    struct Span {
+        int start = 0;
+        int length = 0;
+    };
+    // A prompt matched by a regular expression, with where in the body it matched
+    struct RegexHit {
+        PromptRecord record;
+        QList<Span> matches; // in order, at most the first few
+    };
+    // A short excerpt of a body with the matches inside it, for display
+    struct Snippet {
+        QString text;
+        QList<Span> highlights; // relative to text
+    };
+
+    // Replaces whatever was indexed under the same IDs. Records whose body isn't
+    // loaded are dropped instead, they can't be searched yet.
+    void update(const QList<PromptRecord> &records, QThreadPool *pool = nullptr);
+    void remove(int promptId);
+    void clear();
+
+    // Listing order; search() returns matches in this order
+    void setOrder(const QList<int> &promptIds);
+    // Point updates to it: a new prompt goes last or first, a removed one leaves the
+    // order. All are amortized O(1).
+    void appendToOrder(int promptId);
+    void prependToOrder(int promptId);
+    void removeFromOrder(int promptId);
+
+    // Changes whenever the index does and is unique across indexes, so equal
+    // generations mean identical contents
+    quint64 generation() const { return m_generation; }
+
+    bool contains(int promptId) const { return m_entries.contains(promptId); }
+    // What the prompt was indexed with; invalid if it isn't indexed
+    PromptRecord record(int promptId) const { return m_entries.value(promptId).record; }
+    int size() const { return m_entries.size(); }
+
+    // Prompts matching the query, in listing order. Its text terms narrow the
+    // candidates through the trigram index before the plan is evaluated.
+    QList<PromptRecord> search(const SearchQuery &query, const CancelCheck &cancelled = CancelCheck()) const;
+    // Same, delivering matches progressively; the first batch is kept small so a
+    // screenful can be shown before the rest is verified. Given a pool, large
+    // candidate sets are verified on it in parallel, still delivered in order.
+    void search(const SearchQuery &query, const ResultSink &sink, const CancelCheck &cancelled = CancelCheck(),
+                QThreadPool *pool = nullptr) const;
+    // Same as search(), but only over promptIds, which must be the listing-ordered
+    // matches of a query this one refines, found in an index of the same generation
+    void refine(const SearchQuery &query, const QList<int> &promptIds, const ResultSink &sink,
+                const CancelCheck &cancelled = CancelCheck(), QThreadPool *pool = nullptr) const;
+    // At most limit matches, most relevant to the query's text terms first. Matches
+    // that share no whole word with the query (a term found inside a longer word)
+    // follow in listing order. Queries made only of filters have nothing to rank by
+    // and come back in listing order.
+    QList<PromptRecord> rank(const SearchQuery &query, int limit, const CancelCheck &cancelled = CancelCheck()) const;
+    // Prompts whose body pattern matches, in listing order; folderId > 0 restricts
+    // them to that folder. Large indexes are split into chunks matched on pool. Once
+    // deadline expires, even inside a prompt, the rest is skipped and *timedOut is
+    // set, so a pathological pattern only costs its one slowest match.
+    QList<RegexHit> matchRegex(const QRegularExpression &pattern, int folderId, QThreadPool *pool,
+                               const QDeadlineTimer &deadline, bool *timedOut = nullptr,
+                               const CancelCheck &cancelled = CancelCheck()) const;
+
+    // Where the query's words and phrases occur in body, in order, at most max
+    static QList<Span> locate(const SearchQuery &query, const QString &body, int max);
+    // Where pattern matches body, looking at no more than max matches; *matched is
+    // also set for a match that is empty and so has no span. Stops early once
+    // deadline expires.
+    static QList<Span> locate(const QRegularExpression &pattern, const QString &body, int max,
+                              bool *matched = nullptr,
+                              const QDeadlineTimer &deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    // About length characters of body around the stretch with the most matches,
+    // cut at word boundaries and marked with ellipses where shortened. Line breaks
+    // become spaces. Empty if there are no matches.
+    static Snippet snippet(const QString &body, const QList<Span> &matches, int length);
+
+private:
+    TrigramIndex m_trigrams;
+    Bm25Index m_ranking;
+    // What each prompt was indexed with, and its title and body folded once for
+    // matching (see TextFolding)
+    struct Entry {
+        PromptRecord record;
+        QString folded;
+        bool hasPlaceholders = false;
+    };
+    static SearchQuery::Subject subject(const Entry &entry);
+    QList<int> candidates(const SearchQuery &query) const;
+    QList<PromptRecord> matchRange(const SearchQuery &query, const QList<int> &promptIds, qsizetype begin,
+                                   qsizetype end) const;
+    void evaluate(const SearchQuery &query, const QList<int> &promptIds, const ResultSink &sink,
+                  const CancelCheck &cancelled, QThreadPool *pool) const;
+    void touch();
+
+    QHash<int, Entry> m_entries;
+    QList<int> m_order;              // prompt IDs in listing order, -1 where one was removed
+    QHash<int, int> m_positions;     // prompt ID -> index in m_order plus m_orderStart
+    int m_orderStart = 0;            // goes down as prompts are prepended
+    int m_orderHoles = 0;
+    quint64 m_generation = 0;
+};
+
+#endif // PROMPTSEARCHINDEX_H
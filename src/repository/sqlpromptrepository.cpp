@@ -36,10 +36,6 @@ bool SqlPromptRepository::savePrompt(Prompt *prompt)
         }
     }
     
-    if (success) {
-        emit dataChanged();
-    }
-    
     return success;
 }
 
@@ -48,7 +44,6 @@ bool SqlPromptRepository::deletePrompt(int promptId)
     bool success = m_promptDao->deletePrompt(promptId);
     if (success) {
         emit promptDeleted(promptId);
-        emit dataChanged();
     }
     return success;
 }
@@ -77,6 +72,7 @@ bool SqlPromptRepository::duplicatePrompt(int promptId)
 {
     bool success = m_promptDao->duplicatePrompt(promptId);
     if (success) {
+        // The DAO doesn't hand back the copy
         emit dataChanged();
     }
     return success;
@@ -104,20 +100,23 @@ bool SqlPromptRepository::saveFolder(Folder *folder)
         }
     }
     
-    if (success) {
-        emit dataChanged();
-    }
-    
     return success;
 }
 
 bool SqlPromptRepository::deleteFolder(int folderId)
 {
+    // The foreign key moves the folder's prompts to uncategorized (ON DELETE SET
+    // NULL); they are reported as updated, before the folder itself
+    const QList<Prompt*> prompts = m_promptDao->getPromptsByFolder(folderId);
     bool success = m_folderDao->deleteFolder(folderId);
     if (success) {
+        for (Prompt *prompt : prompts) {
+            prompt->setFolderId(-1);
+            emit promptUpdated(prompt);
+        }
         emit folderDeleted(folderId);
-        emit dataChanged();
     }
+    qDeleteAll(prompts);
     return success;
 }
 
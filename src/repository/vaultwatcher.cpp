@@ -0,0 +1,216 @@
+#include "vaultwatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <QFileSystemWatcher>
+#endif
+
+VaultWatcher::VaultWatcher(QObject *parent)
+    : QObject(parent), m_maxDelayMs(2000)
+{
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(250);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &VaultWatcher::flush);
+
+#ifdef Q_OS_LINUX
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_notifier = nullptr;
+    if (m_inotifyFd == -1) {
+        qWarning() << "inotify unavailable; external changes to the vault will not be picked up";
+    } else {
+        m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &VaultWatcher::readEvents);
+    }
+#else
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &VaultWatcher::markDirty);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        markDirty(QFileInfo(path).absolutePath());
+    });
+#endif
+}
+
+VaultWatcher::~VaultWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd != -1) {
+        ::close(m_inotifyFd);
+    }
+#endif
+}
+
+void VaultWatcher::setDebounce(int debounceMs, int maxDelayMs)
+{
+    m_debounceTimer.setInterval(debounceMs);
+    m_maxDelayMs = maxDelayMs;
+}
+
+void VaultWatcher::setDirectories(const QStringList &directories)
+{
+#ifdef Q_OS_LINUX
+    for (auto it = m_watchDirectories.constBegin(); it != m_watchDirectories.constEnd(); ++it) {
+        inotify_rm_watch(m_inotifyFd, it.key());
+    }
+    m_watchDirectories.clear();
+    m_directoryWatches.clear();
+#else
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+#endif
+    m_debounceTimer.stop();
+    m_dirtyDirectories.clear();
+
+    for (const QString &directory : directories) {
+        addDirectory(directory);
+    }
+}
+
+void VaultWatcher::addDirectory(const QString &directory)
+{
+    const QString path = QDir(directory).absolutePath();
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd == -1 || m_directoryWatches.contains(path)) {
+        return;
+    }
+    const uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                          | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    int wd = inotify_add_watch(m_inotifyFd, QFile::encodeName(path).constData(), mask);
+    if (wd == -1) {
+        qWarning() << "Cannot watch" << path;
+        return;
+    }
+    m_watchDirectories.insert(wd, path);
+    m_directoryWatches.insert(path, wd);
+#else
+    if (m_watcher->addPath(path)) {
+        watchFiles(path);
+    }
+#endif
+}
+
+void VaultWatcher::removeDirectory(const QString &directory)
+{
+    const QString path = QDir(directory).absolutePath();
+#ifdef Q_OS_LINUX
+    int wd = m_directoryWatches.take(path);
+    if (wd > 0) {
+        m_watchDirectories.remove(wd);
+        inotify_rm_watch(m_inotifyFd, wd);
+    }
+#else
+    m_watcher->removePath(path);
+    const QStringList files = m_watcher->files();
+    for (const QString &file : files) {
+        if (QFileInfo(file).absolutePath() == path) {
+            m_watcher->removePath(file);
+        }
+    }
+#endif
+    m_dirtyDirectories.remove(path);
+}
+
+void VaultWatcher::markDirty(const QString &directory)
+{
+    if (m_dirtyDirectories.isEmpty()) {
+        m_pendingSince.start();
+    }
+    m_dirtyDirectories.insert(directory);
+
+    // Keep postponing while events arrive, up to the max delay
+    if (!m_debounceTimer.isActive() || m_pendingSince.elapsed() < m_maxDelayMs) {
+        m_debounceTimer.start();
+    }
+}
+
+void VaultWatcher::flush()
+{
+    if (m_dirtyDirectories.isEmpty()) {
+        return;
+    }
+
+    const QStringList directories(m_dirtyDirectories.cbegin(), m_dirtyDirectories.cend());
+    m_dirtyDirectories.clear();
+
+#ifndef Q_OS_LINUX
+    // Files created since the last flush need their own watch here
+    for (const QString &directory : directories) {
+        watchFiles(directory);
+    }
+#endif
+
+    emit directoriesChanged(directories);
+}
+
+#ifdef Q_OS_LINUX
+void VaultWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (const char *ptr = buffer; ptr < buffer + length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were dropped: everything has to be rescanned
+                for (const QString &directory : std::as_const(m_watchDirectories)) {
+                    markDirty(directory);
+                }
+                continue;
+            }
+
+            const QString directory = m_watchDirectories.value(event->wd);
+            if (directory.isEmpty()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_watchDirectories.remove(event->wd);
+                m_directoryWatches.remove(directory);
+                continue;
+            }
+
+            // Only prompt files and folders matter; skip editor swap files, QSaveFile
+            // temporaries and the like
+            if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+                const QString name = QFile::decodeName(event->name);
+                if (!name.endsWith(".md")) {
+                    continue;
+                }
+            }
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The folder itself went away; its parent sees the change too
+                markDirty(QFileInfo(directory).absolutePath());
+            }
+            markDirty(directory);
+        }
+    }
+}
+#else
+void VaultWatcher::watchFiles(const QString &directory)
+{
+    const QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.md", QDir::Files);
+    QStringList paths;
+    for (const QFileInfo &file : files) {
+        paths.append(file.absoluteFilePath());
+    }
+    if (!paths.isEmpty()) {
+        m_watcher->addPaths(paths);
+    }
+}
+#endif
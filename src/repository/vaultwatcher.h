@@ -0,0 +1,62 @@
+#ifndef VAULTWATCHER_H
+#define VAULTWATCHER_H
+
+#include <QObject>
+#include <QSet>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+
+// Watches the vault root and its folder directories and reports, debounced, which
+// directories need to be rescanned. On Linux it uses inotify directly so in-place
+// edits of a file are reported through its directory without a watch per file;
+// elsewhere it falls back to QFileSystemWatcher on directories and .md files.
+class VaultWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VaultWatcher(QObject *parent = nullptr);
+    ~VaultWatcher() override;
+
+    void setDirectories(const QStringList &directories);
+    void addDirectory(const QString &directory);
+    void removeDirectory(const QString &directory);
+
+    // Changes are reported once no event arrived for debounceMs, but never later
+    // than maxDelayMs after the first one, so a long burst still makes progress
+    void setDebounce(int debounceMs, int maxDelayMs);
+
+signals:
+    void directoriesChanged(const QStringList &directories);
+
+private slots:
+    void flush();
+
+private:
+    void markDirty(const QString &directory);
+
+#ifdef Q_OS_LINUX
+    void readEvents();
+
+    int m_inotifyFd;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_watchDirectories;  // watch descriptor -> directory
+    QHash<QString, int> m_directoryWatches;
+#else
+    void watchFiles(const QString &directory);
+
+    QFileSystemWatcher *m_watcher;
+#endif
+
+    QTimer m_debounceTimer;
+    QElapsedTimer m_pendingSince;
+    int m_maxDelayMs;
+    QSet<QString> m_dirtyDirectories;
+};
+
+#endif // VAULTWATCHER_H
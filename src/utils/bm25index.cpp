@@ -0,0 +1,231 @@
+#include "bm25index.h"
+#include "textfolding.h"
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Standard BM25 parameters; a title occurrence weighs as much as three in the body
+constexpr double kK1 = 1.2;
+constexpr double kB = 0.75;
+constexpr double kTitleWeight = 3.0;
+
+inline quint16 saturatingIncrement(quint16 value)
+{
+    return value == std::numeric_limits<quint16>::max() ? value : quint16(value + 1);
+}
+
+} // namespace
+
+QStringList Bm25Index::tokenize(QStringView text)
+{
+    QStringList tokens;
+    const QString folded = TextFolding::fold(text.toString());
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= folded.size(); ++i) {
+        const bool wordChar = i < folded.size() && folded.at(i).isLetterOrNumber();
+        if (wordChar && start == -1) {
+            start = i;
+        } else if (!wordChar && start != -1) {
+            tokens.append(folded.mid(start, i - start));
+            start = -1;
+        }
+    }
+    return tokens;
+}
+
+Bm25Index::Document Bm25Index::analyze(QStringView title, QStringView body)
+{
+    Document document;
+    const QStringList titleTokens = tokenize(title);
+    const QStringList bodyTokens = tokenize(body);
+    document.titleLength = titleTokens.size();
+    document.bodyLength = bodyTokens.size();
+
+    for (const QString &token : titleTokens) {
+        TermFrequency &frequency = document.terms[token];
+        frequency.title = saturatingIncrement(frequency.title);
+    }
+    for (const QString &token : bodyTokens) {
+        TermFrequency &frequency = document.terms[token];
+        frequency.body = saturatingIncrement(frequency.body);
+    }
+    return document;
+}
+
+double Bm25Index::weightedLength(const Document &document) const
+{
+    return kTitleWeight * document.titleLength + document.bodyLength;
+}
+
+void Bm25Index::insert(int docId, const Document &document)
+{
+    if (m_lengths.contains(docId)) {
+        return;
+    }
+
+    const double length = weightedLength(document);
+    m_lengths.insert(docId, length);
+    m_totalLength += length;
+
+    for (auto it = document.terms.constBegin(); it != document.terms.constEnd(); ++it) {
+        QList<Posting> &postings = m_postings[it.key()];
+        const Posting posting{docId, it.value()};
+        if (postings.isEmpty() || postings.last().docId < docId) {
+            postings.append(posting);
+        } else {
+            auto pos = std::lower_bound(postings.begin(), postings.end(), docId,
+                                        [](const Posting &p, int id) { return p.docId < id; });
+            postings.insert(pos, posting);
+        }
+    }
+}
+
+// Appends everything first and sorts only the posting lists that went out of order
+void Bm25Index::insertBatch(const QList<int> &docIds, const QList<Document> &documents)
+{
+    QSet<QString> unsorted;
+    for (int i = 0; i < docIds.size(); ++i) {
+        const int docId = docIds.at(i);
+        if (m_lengths.contains(docId)) {
+            continue;
+        }
+
+        const Document &document = documents.at(i);
+        const double length = weightedLength(document);
+        m_lengths.insert(docId, length);
+        m_totalLength += length;
+
+        for (auto it = document.terms.constBegin(); it != document.terms.constEnd(); ++it) {
+            QList<Posting> &postings = m_postings[it.key()];
+            if (!postings.isEmpty() && postings.last().docId > docId) {
+                unsorted.insert(it.key());
+            }
+            postings.append(Posting{docId, it.value()});
+        }
+    }
+
+    for (const QString &term : std::as_const(unsorted)) {
+        QList<Posting> &postings = m_postings[term];
+        std::sort(postings.begin(), postings.end(),
+                  [](const Posting &a, const Posting &b) { return a.docId < b.docId; });
+    }
+}
+
+void Bm25Index::remove(int docId, const Document &document)
+{
+    auto length = m_lengths.find(docId);
+    if (length == m_lengths.end()) {
+        return;
+    }
+    m_totalLength -= length.value();
+    m_lengths.erase(length);
+
+    for (auto it = document.terms.constBegin(); it != document.terms.constEnd(); ++it) {
+        auto postings = m_postings.find(it.key());
+        if (postings == m_postings.end()) {
+            continue;
+        }
+        auto pos = std::lower_bound(postings->begin(), postings->end(), docId,
+                                    [](const Posting &p, int id) { return p.docId < id; });
+        if (pos != postings->end() && pos->docId == docId) {
+            postings->erase(pos);
+        }
+        if (postings->isEmpty()) {
+            m_postings.erase(postings);
+        }
+    }
+}
+
+void Bm25Index::clear()
+{
+    m_postings.clear();
+    m_lengths.clear();
+    m_totalLength = 0;
+}
+
+// Adds the term's contribution to each document's score. Expansions of a prefix are
+// alternatives rather than separate terms, so for those only the best one counts.
+void Bm25Index::scoreTerm(const QList<Posting> &postings, QHash<int, double> *scores, bool keepBest) const
+{
+    const double documents = m_lengths.size();
+    const double averageLength = m_totalLength > 0 ? m_totalLength / documents : 1.0;
+    const double df = postings.size();
+    const double idf = std::log(1.0 + (documents - df + 0.5) / (df + 0.5));
+
+    for (const Posting &posting : postings) {
+        const double tf = kTitleWeight * posting.frequency.title + posting.frequency.body;
+        const double norm = 1.0 - kB + kB * m_lengths.value(posting.docId) / averageLength;
+        const double score = idf * tf * (kK1 + 1.0) / (tf + kK1 * norm);
+
+        double &current = (*scores)[posting.docId];
+        current = keepBest ? std::max(current, score) : current + score;
+    }
+}
+
+QList<Bm25Index::Hit> Bm25Index::topK(QStringView query, int limit, const std::function<bool(int)> &filter) const
+{
+    QList<Hit> result;
+    QStringList terms = tokenize(query);
+    if (terms.isEmpty() || limit <= 0 || m_lengths.isEmpty()) {
+        return result;
+    }
+
+    // The last term is still being typed unless the query ends with a separator
+    const bool lastIsPrefix = query.last().isLetterOrNumber();
+    const QString prefix = lastIsPrefix ? terms.takeLast() : QString();
+    terms.removeDuplicates();
+
+    // Term-at-a-time accumulation over the matching postings only
+    QHash<int, double> scores;
+    for (const QString &term : std::as_const(terms)) {
+        if (term == prefix) {
+            continue; // counted through the prefix below
+        }
+        auto postings = m_postings.constFind(term);
+        if (postings != m_postings.constEnd()) {
+            scoreTerm(postings.value(), &scores, false);
+        }
+    }
+    if (!prefix.isEmpty()) {
+        QHash<int, double> best;
+        for (auto it = m_postings.lowerBound(prefix); it != m_postings.constEnd() && it.key().startsWith(prefix); ++it) {
+            scoreTerm(it.value(), &best, true);
+        }
+        for (auto it = best.constBegin(); it != best.constEnd(); ++it) {
+            scores[it.key()] += it.value();
+        }
+    }
+
+    // Bounded min-heap: the weakest of the current top k sits at the front. Ties go to
+    // the lower ID so the order is stable between runs.
+    auto better = [](const Hit &a, const Hit &b) {
+        return a.score > b.score || (a.score == b.score && a.docId < b.docId);
+    };
+    std::vector<Hit> heap;
+    heap.reserve(std::min<qsizetype>(limit, scores.size()));
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        if (filter && !filter(it.key())) {
+            continue;
+        }
+        const Hit hit{it.key(), it.value()};
+        if (int(heap.size()) < limit) {
+            heap.push_back(hit);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(hit, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = hit;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), better);
+    result.reserve(int(heap.size()));
+    for (const Hit &hit : heap) {
+        result.append(hit);
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef BM25INDEX_H
+#define BM25INDEX_H
+
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <functional>
+
+// Word-level inverted index with per-field term frequencies, scored with BM25. Title
+// occurrences count several times over body ones (a simplified BM25F). Only the best
+// hits are kept while scoring, so ranking never sorts the whole match set.
+class Bm25Index
+{
+public:
+    struct TermFrequency {
+        quint16 title = 0;
+        quint16 body = 0;
+    };
+
+    // What a document contributes to the index; computing it is the expensive part
+    // and is safe to do from any thread
+    struct Document {
+        QHash<QString, TermFrequency> terms;
+        int titleLength = 0;
+        int bodyLength = 0;
+    };
+
+    struct Hit {
+        int docId;
+        double score;
+    };
+
+    // Runs of letters and digits, folded as TextFolding does
+    static QStringList tokenize(QStringView text);
+    static Document analyze(QStringView title, QStringView body);
+
+    void insert(int docId, const Document &document);
+    void insertBatch(const QList<int> &docIds, const QList<Document> &documents);
+    // document must be what the document was indexed with
+    void remove(int docId, const Document &document);
+    void clear();
+
+    bool contains(int docId) const { return m_lengths.contains(docId); }
+    int documentCount() const { return m_lengths.size(); }
+
+    // At most limit documents containing any query term, best first. The last term also
+    // matches as a prefix so results follow the user while typing. Documents the filter
+    // rejects are skipped before they reach the heap.
+    QList<Hit> topK(QStringView query, int limit, const std::function<bool(int)> &filter = {}) const;
+
+private:
+    struct Posting {
+        int docId;
+        TermFrequency frequency;
+    };
+
+    double weightedLength(const Document &document) const;
+    void scoreTerm(const QList<Posting> &postings, QHash<int, double> *scores, bool keepBest) const;
+
+    QMap<QString, QList<Posting>> m_postings; // ordered for prefix lookups; postings sorted by ID
+    QHash<int, double> m_lengths;            // weighted length per document
+    double m_totalLength = 0;
+};
+
+#endif // BM25INDEX_H
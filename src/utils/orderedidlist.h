@@ -0,0 +1,102 @@
+#ifndef ORDEREDIDLIST_H
+#define ORDEREDIDLIST_H
+
+#include <QHash>
+#include <QList>
+#include <limits>
+
+// Values keyed by a unique ID, kept in insertion order, with O(1) lookup, append,
+// in-place replacement and removal. Removing leaves a hole instead of shifting the
+// rest of the list. Holes are compacted away once they outnumber the values, which
+// keeps removal amortized O(1) and the storage bounded.
+//
+// values() squeezes the holes out and returns the storage itself, implicitly shared,
+// so listing costs nothing beyond that. The sharing has a price: while a caller
+// still holds a list returned by values(), the next change to this one detaches
+// and copies all n values. Point operations are only O(1) when such copies are
+// short-lived, as with a range-for over values().
+template <typename T>
+class OrderedIdList
+{
+public:
+    int size() const { return m_slots.size(); }
+    bool isEmpty() const { return m_slots.isEmpty(); }
+    bool contains(int id) const { return m_slots.contains(id); }
+
+    T value(int id, const T &defaultValue = T()) const
+    {
+        const auto it = m_slots.constFind(id);
+        return it == m_slots.cend() ? defaultValue : m_values.at(it.value());
+    }
+
+    // Appends, or replaces the value in place if the ID is already present
+    void insert(int id, const T &value)
+    {
+        const auto it = m_slots.constFind(id);
+        if (it != m_slots.cend()) {
+            m_values[it.value()] = value;
+            return;
+        }
+        m_slots.insert(id, m_values.size());
+        m_values.append(value);
+        m_ids.append(id);
+    }
+
+    bool remove(int id)
+    {
+        const auto it = m_slots.constFind(id);
+        if (it == m_slots.cend()) {
+            return false;
+        }
+        m_values[it.value()] = T();
+        m_ids[it.value()] = kHole;
+        m_slots.erase(it);
+        if (m_values.size() - m_slots.size() > m_slots.size()) {
+            compact();
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        m_values.clear();
+        m_ids.clear();
+        m_slots.clear();
+    }
+
+    // In insertion order. Shares the storage; see above for holding on to it.
+    QList<T> values() const
+    {
+        if (m_values.size() != m_slots.size()) {
+            compact();
+        }
+        return m_values;
+    }
+
+private:
+    static constexpr int kHole = std::numeric_limits<int>::min();
+
+    // Only moves values; the visible contents stay the same
+    void compact() const
+    {
+        QList<T> values;
+        QList<int> ids;
+        values.reserve(m_slots.size());
+        ids.reserve(m_slots.size());
+        for (int i = 0; i < m_ids.size(); ++i) {
+            if (m_ids.at(i) != kHole) {
+                m_slots[m_ids.at(i)] = values.size();
+                values.append(m_values.at(i));
+                ids.append(m_ids.at(i));
+            }
+        }
+        m_values = std::move(values);
+        m_ids = std::move(ids);
+    }
+
+    mutable QList<T> m_values;
+    mutable QList<int> m_ids;          // ID of each slot, kHole where one was removed
+    mutable QHash<int, int> m_slots;   // ID -> index in m_values
+};
+
+#endif // ORDEREDIDLIST_H
@@ -0,0 +1,36 @@
+#include "regexcache.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+// Distinct patterns kept compiled
+static const int kMaxCachedPatterns = 64;
+
+QRegularExpression RegexCache::compile(const QString &pattern)
+{
+    static QMutex mutex;
+    static QCache<QString, QRegularExpression> cache(kMaxCachedPatterns);
+
+    QMutexLocker locker(&mutex);
+    if (const QRegularExpression *cached = cache.object(pattern)) {
+        return *cached;
+    }
+
+    QRegularExpression regex(pattern, QRegularExpression::CaseInsensitiveOption |
+                                          QRegularExpression::UseUnicodePropertiesOption);
+    // Compiles (with the JIT where available) now rather than on first match,
+    // which could otherwise happen on several threads at once
+    regex.optimize();
+    cache.insert(pattern, new QRegularExpression(regex));
+    return regex;
+}
+
+bool RegexCache::isPatternQuery(const QString &text)
+{
+    return text.size() > 2 && text.startsWith(QLatin1Char('/')) && text.endsWith(QLatin1Char('/'));
+}
+
+QString RegexCache::patternOf(const QString &text)
+{
+    return isPatternQuery(text) ? text.mid(1, text.size() - 2) : QString();
+}
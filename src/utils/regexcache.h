@@ -0,0 +1,23 @@
+#ifndef REGEXCACHE_H
+#define REGEXCACHE_H
+
+#include <QString>
+#include <QRegularExpression>
+
+// Compiled patterns for regex searches, shared by all threads. A pattern is compiled
+// and JIT-optimized once; later lookups return a copy that shares the compiled code.
+// Recently used patterns are kept, so retyping or refining a search is free.
+class RegexCache
+{
+public:
+    // Case-insensitive and Unicode-aware, like the other searches. The result may be
+    // invalid; check isValid() and errorString().
+    static QRegularExpression compile(const QString &pattern);
+
+    // True for search box text of the form /pattern/
+    static bool isPatternQuery(const QString &text);
+    // The pattern between the slashes of a pattern query
+    static QString patternOf(const QString &text);
+};
+
+#endif // REGEXCACHE_H
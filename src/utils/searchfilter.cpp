@@ -1,4 +1,6 @@
 #include "searchfilter.h"
+#include "placeholderutils.h"
+#include "textfolding.h"
 
 SearchFilter::SearchFilter(QObject *parent)
     : QObject(parent)
@@ -10,51 +12,57 @@ QList<Prompt*> SearchFilter::filterPrompts(const QList<Prompt*> &prompts, const
     if (searchText.isEmpty()) {
         return prompts;
     }
-
-    QList<Prompt*> filtered;
-    for (Prompt *prompt : prompts) {
-        if (matchesSearch(prompt, searchText)) {
-            filtered.append(prompt);
-        }
-    }
-    return filtered;
+    return applyFilters(prompts, searchText, -1);
 }
 
 QList<Prompt*> SearchFilter::filterByFolder(const QList<Prompt*> &prompts, int folderId)
 {
-    QList<Prompt*> filtered;
-    for (Prompt *prompt : prompts) {
-        if (matchesFolder(prompt, folderId)) {
-            filtered.append(prompt);
-        }
-    }
-    return filtered;
+    return applyFilters(prompts, QString(), folderId);
 }
 
+// The text is parsed as a query; there is no folder list to resolve folder: terms
+// against here, so those match nothing
 QList<Prompt*> SearchFilter::applyFilters(const QList<Prompt*> &prompts, const QString &searchText, int folderId)
 {
-    QList<Prompt*> result = prompts;
-    
-    if (folderId >= 0) {
-        result = filterByFolder(result, folderId);
+    return applyQuery(prompts, SearchQuery::parse(searchText), folderId);
+}
+
+// All predicates are evaluated in one pass, without intermediate lists. This runs on
+// the calling thread: Prompt caches its folded text on first use, so prompts must
+// not be matched from several threads. Searches over the whole library go through
+// the repository's PromptSearchIndex, which is safe to query from a worker.
+QList<Prompt*> SearchFilter::applyQuery(const QList<Prompt*> &prompts, const SearchQuery &query, int folderId)
+{
+    if (folderId < 0 && query.isEmpty()) {
+        return prompts;
     }
-    
-    if (!searchText.isEmpty()) {
-        result = filterPrompts(result, searchText);
+
+    QList<Prompt*> filtered;
+    for (Prompt *prompt : prompts) {
+        if ((folderId < 0 || matchesFolder(prompt, folderId)) && matchesSearch(prompt, query)) {
+            filtered.append(prompt);
+        }
     }
-    
-    return result;
+    return filtered;
 }
 
-bool SearchFilter::matchesSearch(Prompt *prompt, const QString &searchText)
+// Text terms are matched against the prompt's folded title and body
+bool SearchFilter::matchesSearch(Prompt *prompt, const SearchQuery &query)
 {
-    if (!prompt || searchText.isEmpty()) {
+    if (!prompt || query.isEmpty()) {
         return true;
     }
 
-    QString lowerSearchText = searchText.toLower();
-    return prompt->title().toLower().contains(lowerSearchText) ||
-           prompt->content().toLower().contains(lowerSearchText);
+    SearchQuery::Subject subject;
+    subject.folderId = prompt->folderId();
+    subject.createdAt = prompt->createdAt();
+    subject.updatedAt = prompt->updatedAt();
+    const QString folded = TextFolding::fold(prompt->title() + QLatin1Char('\n') + prompt->content());
+    subject.foldedText = folded;
+    if (query.needsPlaceholders()) {
+        subject.hasPlaceholders = PlaceholderUtils::hasPlaceholders(prompt->content());
+    }
+    return query.matches(subject);
 }
 
 bool SearchFilter::matchesFolder(Prompt *prompt, int folderId)
@@ -73,4 +81,4 @@ bool SearchFilter::matchesFolder(Prompt *prompt, int folderId)
         // All prompts (folderId == -1)
         return true;
     }
-}
\ No newline at end of file
+}
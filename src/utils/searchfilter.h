@@ -5,6 +5,7 @@
 #include <QString>
 #include <QList>
 #include "../models/prompt.h"
+#include "searchquery.h"
 
 class SearchFilter : public QObject
 {
@@ -17,9 +18,11 @@ public:
     static QList<Prompt*> filterPrompts(const QList<Prompt*> &prompts, const QString &searchText);
     static QList<Prompt*> filterByFolder(const QList<Prompt*> &prompts, int folderId);
     static QList<Prompt*> applyFilters(const QList<Prompt*> &prompts, const QString &searchText, int folderId);
+    // Compiled query; folderId as in filterByFolder, -1 for all
+    static QList<Prompt*> applyQuery(const QList<Prompt*> &prompts, const SearchQuery &query, int folderId = -1);
 
 private:
-    static bool matchesSearch(Prompt *prompt, const QString &searchText);
+    static bool matchesSearch(Prompt *prompt, const SearchQuery &query);
     static bool matchesFolder(Prompt *prompt, int folderId);
 };
 
@@ -0,0 +1,269 @@
+#include "searchquery.h"
+#include <algorithm>
+
+namespace {
+
+// Splits off the next token. A token is an optional '-', an optional "key:" and a
+// value that is either a quoted phrase or runs up to the next space.
+struct Token {
+    bool negated = false;
+    QString key;
+    QString value;
+    bool quoted = false;
+};
+
+bool nextToken(const QString &text, qsizetype *pos, Token *token)
+{
+    qsizetype i = *pos;
+    while (i < text.size() && text.at(i).isSpace()) {
+        ++i;
+    }
+    if (i >= text.size()) {
+        return false;
+    }
+
+    *token = Token();
+    if (text.at(i) == QLatin1Char('-') && i + 1 < text.size() && !text.at(i + 1).isSpace()) {
+        token->negated = true;
+        ++i;
+    }
+
+    qsizetype keyEnd = i;
+    while (keyEnd < text.size() && text.at(keyEnd).isLetter()) {
+        ++keyEnd;
+    }
+    if (keyEnd > i && keyEnd + 1 < text.size() && text.at(keyEnd) == QLatin1Char(':') && !text.at(keyEnd + 1).isSpace()) {
+        token->key = text.mid(i, keyEnd - i).toLower();
+        i = keyEnd + 1;
+    }
+
+    if (text.at(i) == QLatin1Char('"')) {
+        const qsizetype close = text.indexOf(QLatin1Char('"'), i + 1);
+        const qsizetype end = close == -1 ? text.size() : close;
+        token->value = text.mid(i + 1, end - i - 1);
+        token->quoted = true;
+        i = close == -1 ? text.size() : close + 1;
+    } else {
+        const qsizetype start = i;
+        while (i < text.size() && !text.at(i).isSpace()) {
+            ++i;
+        }
+        token->value = text.mid(start, i - start);
+    }
+
+    *pos = i;
+    return true;
+}
+
+} // namespace
+
+SearchQuery SearchQuery::parse(const QString &text, const FolderLookup &folderLookup)
+{
+    SearchQuery query;
+    qsizetype pos = 0;
+    Token token;
+    while (nextToken(text, &pos, &token)) {
+        Clause clause;
+        clause.negated = token.negated;
+
+        bool filter = true;
+        if (token.key == QLatin1String("title")) {
+            clause.kind = Kind::Title;
+        } else if (token.key == QLatin1String("folder")) {
+            clause.kind = Kind::Folder;
+            clause.folderId = folderLookup ? folderLookup(token.value) : -1;
+        } else if (token.key == QLatin1String("updated") || token.key == QLatin1String("created")) {
+            clause.kind = token.key == QLatin1String("updated") ? Kind::Updated : Kind::Created;
+            filter = parseDate(token.value, &clause.comparison, &clause.date);
+        } else if (token.key == QLatin1String("has")) {
+            clause.kind = Kind::Placeholders;
+            filter = token.value.compare(QLatin1String("placeholders"), Qt::CaseInsensitive) == 0 ||
+                     token.value.compare(QLatin1String("placeholder"), Qt::CaseInsensitive) == 0;
+        } else {
+            filter = token.key.isEmpty();
+        }
+
+        if (!filter) {
+            // Not a filter after all: search for what was typed
+            clause.kind = Kind::Text;
+            const QString raw = token.key + QLatin1Char(':') + token.value;
+            clause.matcher = TextFolding::Matcher(raw);
+        } else if (clause.kind == Kind::Title || clause.kind == Kind::Text) {
+            clause.matcher = TextFolding::Matcher(token.value);
+            if (clause.matcher.isEmpty()) {
+                continue; // "" or a lone '-'
+            }
+        }
+        query.addClause(clause);
+    }
+    return query;
+}
+
+void SearchQuery::restrictToFolder(int folderId)
+{
+    Clause clause;
+    clause.kind = Kind::Folder;
+    clause.folderId = folderId;
+    addClause(clause);
+}
+
+void SearchQuery::addClause(const Clause &clause)
+{
+    // Stable, so clauses of one kind keep the order they were typed in
+    auto pos = std::upper_bound(m_clauses.begin(), m_clauses.end(), clause,
+                                [](const Clause &a, const Clause &b) { return a.kind < b.kind; });
+    m_clauses.insert(pos, clause);
+    if (clause.kind == Kind::Placeholders) {
+        m_needsPlaceholders = true;
+    }
+}
+
+bool SearchQuery::parseDate(const QString &value, Comparison *comparison, QDate *date)
+{
+    static const struct {
+        const char *prefix;
+        Comparison comparison;
+    } operators[] = {
+        {">=", Comparison::OnOrAfter},
+        {"<=", Comparison::BeforeOrOn},
+        {">", Comparison::After},
+        {"<", Comparison::Before},
+        {"=", Comparison::On},
+    };
+
+    QString dateText = value;
+    *comparison = Comparison::On;
+    for (const auto &op : operators) {
+        if (value.startsWith(QLatin1String(op.prefix))) {
+            *comparison = op.comparison;
+            dateText = value.mid(qstrlen(op.prefix));
+            break;
+        }
+    }
+
+    *date = QDate::fromString(dateText, Qt::ISODate);
+    return date->isValid();
+}
+
+QStringList SearchQuery::requiredText() const
+{
+    QStringList result;
+    for (const Clause &clause : m_clauses) {
+        if (!clause.negated && (clause.kind == Kind::Title || clause.kind == Kind::Text)) {
+            result.append(clause.matcher.needle());
+        }
+    }
+    return result;
+}
+
+QString SearchQuery::rankingText() const
+{
+    return requiredText().join(QLatin1Char(' '));
+}
+
+bool SearchQuery::matches(const Subject &subject) const
+{
+    for (const Clause &clause : m_clauses) {
+        if (evaluate(clause, subject) == clause.negated) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString SearchQuery::key() const
+{
+    QString key;
+    for (const Clause &clause : m_clauses) {
+        if (clause.negated) {
+            key += QLatin1Char('-');
+        }
+        key += QString::number(static_cast<int>(clause.kind));
+        switch (clause.kind) {
+        case Kind::Folder:
+            key += QString::number(clause.folderId);
+            break;
+        case Kind::Created:
+        case Kind::Updated:
+            key += QString::number(static_cast<int>(clause.comparison)) + clause.date.toString(Qt::ISODate);
+            break;
+        case Kind::Placeholders:
+            break;
+        case Kind::Title:
+        case Kind::Text:
+            key += clause.matcher.needle();
+            break;
+        }
+        key += QChar(0x1f); // unit separator, can't be typed into the search box
+    }
+    return key;
+}
+
+bool SearchQuery::refines(const SearchQuery &previous) const
+{
+    for (const Clause &other : previous.m_clauses) {
+        const bool implied = std::any_of(m_clauses.cbegin(), m_clauses.cend(), [&other](const Clause &clause) {
+            return implies(clause, other);
+        });
+        if (!implied) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether every prompt matching clause also matches other
+bool SearchQuery::implies(const Clause &clause, const Clause &other)
+{
+    if (clause.negated != other.negated) {
+        return false;
+    }
+
+    const bool textual = clause.kind == Kind::Title || clause.kind == Kind::Text;
+    if (textual && (other.kind == Kind::Title || other.kind == Kind::Text)) {
+        if (clause.negated) {
+            // Excluding a longer text excludes less
+            return clause.kind == other.kind && clause.matcher.needle() == other.matcher.needle();
+        }
+        // The folded text starts with the title, so a title match is a text match
+        const bool widerKind = clause.kind == other.kind || other.kind == Kind::Text;
+        return widerKind && clause.matcher.needle().contains(other.matcher.needle());
+    }
+
+    return clause.kind == other.kind && clause.folderId == other.folderId &&
+           clause.comparison == other.comparison && clause.date == other.date;
+}
+
+bool SearchQuery::evaluate(const Clause &clause, const Subject &subject) const
+{
+    switch (clause.kind) {
+    case Kind::Folder:
+        return clause.folderId != -1 && subject.folderId == clause.folderId;
+    case Kind::Created:
+    case Kind::Updated: {
+        const QDate date = (clause.kind == Kind::Created ? subject.createdAt : subject.updatedAt).date();
+        switch (clause.comparison) {
+        case Comparison::Before:
+            return date < clause.date;
+        case Comparison::BeforeOrOn:
+            return date <= clause.date;
+        case Comparison::On:
+            return date == clause.date;
+        case Comparison::OnOrAfter:
+            return date >= clause.date;
+        case Comparison::After:
+            return date > clause.date;
+        }
+        return false;
+    }
+    case Kind::Placeholders:
+        return subject.hasPlaceholders;
+    case Kind::Title: {
+        const qsizetype titleEnd = subject.foldedText.indexOf(QLatin1Char('\n'));
+        return clause.matcher.matches(titleEnd == -1 ? subject.foldedText : subject.foldedText.left(titleEnd));
+    }
+    case Kind::Text:
+        return clause.matcher.matches(subject.foldedText);
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+#ifndef SEARCHQUERY_H
+#define SEARCHQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <functional>
+#include "textfolding.h"
+
+// A search box query compiled into a predicate plan. Supported syntax:
+//
+//   word "exact phrase"        title or body contains it (folded, see TextFolding)
+//   title:word title:"a b"     title contains it
+//   folder:Coding              prompt is in that folder (case-insensitive name)
+//   updated:>2026-01-01        also >=, <, <=, = or a bare date; created: likewise
+//   has:placeholders           body contains a {{placeholder}}
+//   -term                      negates any of the above
+//
+// Anything that doesn't parse as a filter is searched for as text. Clauses are
+// sorted cheapest first, so body text is only matched for prompts that passed the
+// folder, date and placeholder checks.
+class SearchQuery
+{
+public:
+    // Folder ID for a name, or -1 if there is no such folder
+    using FolderLookup = std::function<int(const QString &name)>;
+
+    // What a clause is checked against
+    struct Subject {
+        int folderId = -1;
+        QDateTime createdAt;
+        QDateTime updatedAt;
+        QStringView foldedText;       // folded title + '\n' + body
+        bool hasPlaceholders = false; // only read when needsPlaceholders()
+    };
+
+    SearchQuery() = default;
+    static SearchQuery parse(const QString &text, const FolderLookup &folderLookup = FolderLookup());
+
+    // Adds a filter on top of the parsed ones (the folder picked in the UI)
+    void restrictToFolder(int folderId);
+
+    bool isEmpty() const { return m_clauses.isEmpty(); }
+    bool needsPlaceholders() const { return m_needsPlaceholders; }
+
+    // Folded words and phrases every match contains, for narrowing through an index
+    QStringList requiredText() const;
+    // The positive text terms, for relevance ranking; empty for pure filters
+    QString rankingText() const;
+
+    bool matches(const Subject &subject) const;
+
+    // Canonical form of the plan: texts that compile to the same clauses (spacing,
+    // case, accents, filter order) share it
+    QString key() const;
+
+    // True if everything this query matches is also matched by previous, e.g.
+    // "summar" after "summ", or an added word. Then only previous's matches need to
+    // be checked again.
+    bool refines(const SearchQuery &previous) const;
+
+private:
+    // Declared cheapest first; the plan is evaluated in this order
+    enum class Kind {
+        Folder,
+        Created,
+        Updated,
+        Placeholders,
+        Title,
+        Text
+    };
+
+    enum class Comparison {
+        Before,
+        BeforeOrOn,
+        On,
+        OnOrAfter,
+        After
+    };
+
+    struct Clause {
+        Kind kind = Kind::Text;
+        bool negated = false;
+        int folderId = -1;
+        Comparison comparison = Comparison::On;
+        QDate date;
+        TextFolding::Matcher matcher;
+    };
+
+    static bool parseDate(const QString &value, Comparison *comparison, QDate *date);
+    bool evaluate(const Clause &clause, const Subject &subject) const;
+    static bool implies(const Clause &clause, const Clause &other);
+    void addClause(const Clause &clause);
+
+    QList<Clause> m_clauses;
+    bool m_needsPlaceholders = false;
+};
+
+#endif // SEARCHQUERY_H
@@ -21,6 +21,11 @@ public:
         return m_promptsPath;
     }
 
+    // Threads used to scan the prompts folder; 0 picks one per CPU core
+    int scanWorkerCount() const {
+        return m_settings.value("scanWorkerCount", 0).toInt();
+    }
+
     void setPromptsPath(const QString &path) {
         if (m_promptsPath != path) {
             m_promptsPath = path;
@@ -0,0 +1,66 @@
+#include "textfolding.h"
+
+QString TextFolding::fold(const QString &text)
+{
+    // Most prompts are plain ASCII: that only needs lowercasing, and often not even that
+    bool needsLowercase = false;
+    bool ascii = true;
+    for (const QChar c : text) {
+        const char16_t u = c.unicode();
+        if (u >= 0x80) {
+            ascii = false;
+            break;
+        }
+        if (u >= 'A' && u <= 'Z') {
+            needsLowercase = true;
+        }
+    }
+    if (ascii) {
+        return needsLowercase ? text.toLower() : text;
+    }
+
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString stripped;
+    stripped.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            stripped.append(c);
+        }
+    }
+    return stripped.toCaseFolded();
+}
+
+QString TextFolding::fold(const QString &text, QList<int> *sourcePositions)
+{
+    QString folded;
+    folded.reserve(text.size());
+    sourcePositions->clear();
+    sourcePositions->reserve(text.size() + 1);
+
+    for (int i = 0; i < text.size();) {
+        const char16_t u = text.at(i).unicode();
+        if (u < 0x80) {
+            folded.append(u >= 'A' && u <= 'Z' ? QChar(u + ('a' - 'A')) : QChar(u));
+            sourcePositions->append(i);
+            ++i;
+            continue;
+        }
+
+        // Decomposition and case folding work per code point; a mark stripped here
+        // simply yields nothing
+        const int length = (QChar::isHighSurrogate(u) && i + 1 < text.size()) ? 2 : 1;
+        const QString part = fold(text.mid(i, length));
+        folded.append(part);
+        for (int k = 0; k < part.size(); ++k) {
+            sourcePositions->append(i);
+        }
+        i += length;
+    }
+    sourcePositions->append(text.size());
+    return folded;
+}
+
+TextFolding::Matcher::Matcher(const QString &needle)
+    : m_needle(fold(needle)), m_matcher(m_needle, Qt::CaseSensitive)
+{
+}
@@ -0,0 +1,44 @@
+#ifndef TEXTFOLDING_H
+#define TEXTFOLDING_H
+
+#include <QString>
+#include <QStringView>
+#include <QStringMatcher>
+#include <QList>
+
+// Normalization used by every search: Unicode case folding on the compatibility
+// decomposition (NFKD) with non-spacing marks removed, so "Café", "CAFE" and "café"
+// all fold to "cafe". Searches compare folded text with a plain, case-sensitive
+// substring search, which is much cheaper than folding both sides per comparison.
+class TextFolding
+{
+public:
+    // Returns the input itself, without copying, when it is already folded
+    static QString fold(const QString &text);
+    // Same folding, one character at a time, recording for each folded character
+    // the index in text it came from, followed by text.size(). Slower; meant for
+    // mapping matches in the folded text back to the original.
+    static QString fold(const QString &text, QList<int> *sourcePositions);
+
+    // Finds one folded needle in many folded texts. The needle is folded and its
+    // skip table built once; matching allocates nothing.
+    class Matcher
+    {
+    public:
+        Matcher() = default;
+        explicit Matcher(const QString &needle);
+
+        bool isEmpty() const { return m_needle.isEmpty(); }
+        const QString &needle() const { return m_needle; }
+
+        // foldedText must come from fold()
+        bool matches(QStringView foldedText) const { return m_matcher.indexIn(foldedText) != -1; }
+        qsizetype indexIn(QStringView foldedText, qsizetype from = 0) const { return m_matcher.indexIn(foldedText, from); }
+
+    private:
+        QString m_needle;
+        QStringMatcher m_matcher;
+    };
+};
+
+#endif // TEXTFOLDING_H
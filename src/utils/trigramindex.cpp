@@ -0,0 +1,140 @@
+#include "trigramindex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+inline TrigramIndex::Trigram trigramKey(char16_t a, char16_t b, char16_t c)
+{
+    // Latin, Greek and Cyrillic fit exactly in 10 bits per character
+    if (a < 0x400 && b < 0x400 && c < 0x400) {
+        return (quint32(a) << 20) | (quint32(b) << 10) | quint32(c);
+    }
+    const quint32 h = (quint32(a) * 0x9E3779B1u) ^ (quint32(b) * 0x85EBCA77u) ^ (quint32(c) * 0xC2B2AE3Du);
+    return h | 0x80000000u;
+}
+
+} // namespace
+
+QList<TrigramIndex::Trigram> TrigramIndex::trigrams(QStringView text)
+{
+    QList<Trigram> result;
+    if (text.size() < 3) {
+        return result;
+    }
+
+    result.reserve(text.size() - 2);
+    const char16_t *data = text.utf16();
+    for (qsizetype i = 0; i + 2 < text.size(); ++i) {
+        result.append(trigramKey(data[i], data[i + 1], data[i + 2]));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void TrigramIndex::insert(int docId, const QList<Trigram> &trigrams)
+{
+    if (m_documents.contains(docId)) {
+        return;
+    }
+    m_documents.insert(docId);
+
+    for (Trigram trigram : trigrams) {
+        QList<int> &postings = m_postings[trigram];
+        if (postings.isEmpty() || postings.last() < docId) {
+            postings.append(docId);
+        } else {
+            postings.insert(std::lower_bound(postings.begin(), postings.end(), docId), docId);
+        }
+    }
+}
+
+// Appends everything first and sorts only the posting lists that went out of order,
+// which is much cheaper than sorted inserts when indexing a whole vault
+void TrigramIndex::insertBatch(const QList<int> &docIds, const QList<QList<Trigram>> &trigrams)
+{
+    QSet<Trigram> unsorted;
+    for (int i = 0; i < docIds.size(); ++i) {
+        const int docId = docIds.at(i);
+        if (m_documents.contains(docId)) {
+            continue;
+        }
+        m_documents.insert(docId);
+
+        for (Trigram trigram : trigrams.at(i)) {
+            QList<int> &postings = m_postings[trigram];
+            if (!postings.isEmpty() && postings.last() > docId) {
+                unsorted.insert(trigram);
+            }
+            postings.append(docId);
+        }
+    }
+
+    for (Trigram trigram : std::as_const(unsorted)) {
+        QList<int> &postings = m_postings[trigram];
+        std::sort(postings.begin(), postings.end());
+    }
+}
+
+void TrigramIndex::remove(int docId, QStringView text)
+{
+    if (!m_documents.remove(docId)) {
+        return;
+    }
+
+    const QList<Trigram> keys = trigrams(text);
+    for (Trigram trigram : keys) {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end()) {
+            continue;
+        }
+        auto pos = std::lower_bound(it->begin(), it->end(), docId);
+        if (pos != it->end() && *pos == docId) {
+            it->erase(pos);
+        }
+        if (it->isEmpty()) {
+            m_postings.erase(it);
+        }
+    }
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+    m_documents.clear();
+}
+
+bool TrigramIndex::candidates(QStringView query, QList<int> *result) const
+{
+    const QList<Trigram> keys = trigrams(query);
+    if (keys.isEmpty()) {
+        return false;
+    }
+
+    // Intersect starting from the rarest trigram so the working set only shrinks
+    QList<const QList<int> *> lists;
+    lists.reserve(keys.size());
+    for (Trigram trigram : keys) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd()) {
+            result->clear();
+            return true;
+        }
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const QList<int> *a, const QList<int> *b) {
+        return a->size() < b->size();
+    });
+
+    QList<int> current = *lists.first();
+    QList<int> next;
+    for (int i = 1; i < lists.size() && !current.isEmpty(); ++i) {
+        next.clear();
+        std::set_intersection(current.cbegin(), current.cend(), lists.at(i)->cbegin(), lists.at(i)->cend(),
+                              std::back_inserter(next));
+        current.swap(next);
+    }
+    *result = current;
+    return true;
+}
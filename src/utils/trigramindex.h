@@ -0,0 +1,39 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QStringView>
+
+// Inverted index from character trigrams to the documents containing them, used to
+// narrow substring searches before the actual match is verified. Callers index and
+// query folded text (see TextFolding). Trigrams outside the common alphabets are hashed into a
+// shared key space; a collision only adds a candidate, it never hides a match.
+class TrigramIndex
+{
+public:
+    using Trigram = quint32;
+
+    // Sorted and unique; safe to call from any thread
+    static QList<Trigram> trigrams(QStringView text);
+
+    void insert(int docId, const QList<Trigram> &trigrams);
+    void insertBatch(const QList<int> &docIds, const QList<QList<Trigram>> &trigrams);
+    // text must be what the document was indexed with
+    void remove(int docId, QStringView text);
+    void clear();
+
+    bool contains(int docId) const { return m_documents.contains(docId); }
+    int documentCount() const { return m_documents.size(); }
+
+    // Sorted IDs of the documents containing every trigram of the query. Returns false,
+    // leaving result untouched, when the query is too short to narrow anything down.
+    bool candidates(QStringView query, QList<int> *result) const;
+
+private:
+    QHash<Trigram, QList<int>> m_postings; // sorted document IDs
+    QSet<int> m_documents;
+};
+
+#endif // TRIGRAMINDEX_H
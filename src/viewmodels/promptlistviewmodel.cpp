@@ -1,60 +1,125 @@
 #include "promptlistviewmodel.h"
 #include "../repository/promptrepository.h"
+#include "../utils/textfolding.h"
+#include "../utils/placeholderutils.h"
+#include "../utils/regexcache.h"
+#include <QQmlEngine>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QDebug>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+// Ranked results past this are too weak to be worth showing
+static const int kRankedResultLimit = 100;
+
+// More queued changes than this are cheaper to apply as one reset
+static const int kMaxIncrementalChanges = 64;
+
+// A /pattern/ search gives up after this long and shows what it found
+static const int kRegexTimeoutMs = 500;
+
+// Debounce bounds. Searches faster than kImmediateLatencyMs on average start on the
+// next event loop pass; slower ones wait for a pause in typing of about their own
+// duration, so a search isn't started only to be cancelled by the next key.
+static const int kInitialDebounceMs = 150;
+static const int kMinDebounceMs = 50;
+static const int kMaxDebounceMs = 600;
+static const double kImmediateLatencyMs = 10.0;
+static const double kDebounceLatencyFactor = 1.5;
+// Weight of the newest sample in the latency average
+static const double kLatencySmoothing = 0.3;
+
+// Distinct searches remembered for switching back to them
+static const int kResultCacheSize = 16;
+
+// Cards show a line or two of the body; only this much of it is ever looked at
+static const int kPreviewLength = 160;
+
+// Matches located per row for its snippet
+static const int kMaxHighlights = 16;
+// Locating a /pattern/'s matches for a row runs on the GUI thread as the row is
+// painted, so it gets far less time than the search itself; past it the snippet
+// shows what was found so far
+static const int kHighlightTimeoutMs = 50;
 
 PromptListViewModel::PromptListViewModel(PromptRepository *repository, QObject *parent)
-    : QAbstractListModel(parent), m_repository(repository), m_selectedFolderId(-1),
-      m_isLoading(false)
+    : QAbstractListModel(parent), m_repository(repository), m_totalCount(0), m_uncategorizedCount(0),
+      m_rankedSearch(false), m_selectedFolderId(-1),
+      m_isLoading(false), m_refreshPending(false), m_updateScheduled(false), m_foldersStale(false),
+      m_searchLatency(0.0), m_searchWatcher(nullptr), m_loadGeneration(0), m_searchComplete(true),
+      m_searchHasResults(false), m_waitingForIndex(false)
 {
+    m_searchPool.setMaxThreadCount(1);
+    m_resultCache.setMaxCost(kResultCacheSize);
+
     m_searchTimer = new QTimer(this);
     m_searchTimer->setSingleShot(true);
-    m_searchTimer->setInterval(300); // 300ms debounce
+    m_searchTimer->setInterval(kInitialDebounceMs); // until searches have been timed
     connect(m_searchTimer, &QTimer::timeout, this, &PromptListViewModel::onSearchTimerTimeout);
     
-    // Connect to repository signals
+    // Connect to repository signals. Granular changes become row operations; only bulk
+    // changes reset the model. External edits arrive in bursts, so both are coalesced.
     connect(m_repository, &PromptRepository::dataChanged, this, &PromptListViewModel::onDataChanged);
+    connect(m_repository, &PromptRepository::promptAdded, this, &PromptListViewModel::onPromptChanged);
+    connect(m_repository, &PromptRepository::promptUpdated, this, &PromptListViewModel::onPromptChanged);
+    connect(m_repository, &PromptRepository::promptDeleted, this, &PromptListViewModel::onPromptDeleted);
+    connect(m_repository, &PromptRepository::folderAdded, this, &PromptListViewModel::onFolderChanged);
+    connect(m_repository, &PromptRepository::folderUpdated, this, &PromptListViewModel::onFolderUpdated);
+    connect(m_repository, &PromptRepository::folderDeleted, this, &PromptListViewModel::onFolderDeleted);
+    connect(m_repository, &PromptRepository::searchIndexReady, this, &PromptListViewModel::onSearchIndexReady);
     
     // Load initial data
     refreshData();
 }
 
+PromptListViewModel::~PromptListViewModel()
+{
+    cancelSearch();
+    m_searchPool.waitForDone();
+}
+
 int PromptListViewModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_prompts.size();
+    return m_rows.size();
 }
 
 QVariant PromptListViewModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() >= m_prompts.size()) {
+    if (!index.isValid() || index.row() >= m_rows.size()) {
         return QVariant();
     }
     
-    Prompt *prompt = m_prompts.at(index.row());
+    const Row &row = m_rows.at(index.row());
+    const PromptRecord &prompt = row.prompt;
     
     switch (role) {
     case IdRole:
-        return prompt->id();
+        return prompt.id();
     case TitleRole:
-        return prompt->title();
+        return prompt.title();
     case ContentRole:
-        return prompt->content();
-    case FolderIdRole:
-        return prompt->folderId();
-    case FolderNameRole: {
-        if (prompt->folderId() > 0) {
-            for (Folder *folder : m_folders) {
-                if (folder->id() == prompt->folderId()) {
-                    return folder->name();
-                }
-            }
+        // Repositories may defer reading bodies; only rows actually shown pay for it
+        if (!prompt.isContentLoaded()) {
+            return m_repository->getPromptContent(prompt.id());
         }
-        return QString();
-    }
+        return prompt.content();
+    case FolderIdRole:
+        return prompt.folderId();
+    case FolderNameRole:
+        prepareDisplay(row);
+        return row.folderName;
+    case PreviewRole:
+        prepareDisplay(row);
+        return row.preview;
+    case SnippetRole:
+        prepareDisplay(row);
+        return row.snippet;
     case CreatedAtRole:
-        return prompt->createdAt();
+        return prompt.createdAt();
     case UpdatedAtRole:
-        return prompt->updatedAt();
+        return prompt.updatedAt();
     case PromptObjectRole:
         return QVariant::fromValue(prompt);
     default:
@@ -73,6 +138,8 @@ QHash<int, QByteArray> PromptListViewModel::roleNames() const
     roles[CreatedAtRole] = "createdAt";
     roles[UpdatedAtRole] = "updatedAt";
     roles[PromptObjectRole] = "promptObject";
+    roles[PreviewRole] = "preview";
+    roles[SnippetRole] = "snippet";
     return roles;
 }
 
@@ -88,6 +155,17 @@ void PromptListViewModel::setSearchText(const QString &searchText)
     }
 }
 
+void PromptListViewModel::setRankedSearch(bool ranked)
+{
+    if (m_rankedSearch != ranked) {
+        m_rankedSearch = ranked;
+        emit rankedSearchChanged();
+        if (!m_searchText.isEmpty()) {
+            loadPrompts();
+        }
+    }
+}
+
 void PromptListViewModel::setSelectedFolderId(int folderId)
 {
     if (m_selectedFolderId != folderId) {
@@ -112,42 +190,38 @@ void PromptListViewModel::refreshData()
     loadPrompts();
 }
 
+// The list follows through the repository's change signals
 void PromptListViewModel::deletePrompt(int promptId)
 {
-    setIsLoading(true);
-    
     if (m_repository->deletePrompt(promptId)) {
-        loadPrompts();
         emit promptDeleted(promptId);
     } else {
         setErrorMessage("Failed to delete prompt");
     }
-    
-    setIsLoading(false);
 }
 
 void PromptListViewModel::duplicatePrompt(int promptId)
 {
-    setIsLoading(true);
-    
     if (m_repository->duplicatePrompt(promptId)) {
-        loadPrompts();
         emit promptDuplicated();
     } else {
         setErrorMessage("Failed to duplicate prompt");
     }
-    
-    setIsLoading(false);
 }
 
+// The list holds records, so QML gets a fresh copy it owns and garbage collects
 Prompt* PromptListViewModel::getPromptById(int promptId)
 {
-    for (Prompt *prompt : m_prompts) {
-        if (prompt->id() == promptId) {
-            return prompt;
-        }
+    Prompt *prompt = m_repository->getPromptById(promptId);
+    if (prompt) {
+        QQmlEngine::setObjectOwnership(prompt, QQmlEngine::JavaScriptOwnership);
     }
-    return nullptr;
+    return prompt;
+}
+
+QString PromptListViewModel::getPromptContent(int promptId)
+{
+    return m_repository->getPromptContent(promptId);
 }
 
 void PromptListViewModel::onSearchTimerTimeout()
@@ -157,46 +231,497 @@ void PromptListViewModel::onSearchTimerTimeout()
 
 void PromptListViewModel::onDataChanged()
 {
-    refreshData();
+    if (m_refreshPending) {
+        return;
+    }
+
+    m_refreshPending = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_refreshPending = false;
+        refreshData();
+    }, Qt::QueuedConnection);
+}
+
+void PromptListViewModel::onPromptChanged(Prompt *prompt)
+{
+    m_changedPromptIds.append(prompt->id());
+    scheduleUpdate();
+}
+
+void PromptListViewModel::onPromptDeleted(int promptId)
+{
+    m_deletedPromptIds.append(promptId);
+    scheduleUpdate();
+}
+
+void PromptListViewModel::onFolderUpdated(Folder *folder)
+{
+    m_changedFolderIds.insert(folder->id());
+    onFolderChanged();
+}
+
+void PromptListViewModel::onFolderDeleted(int folderId)
+{
+    m_changedFolderIds.insert(folderId);
+    onFolderChanged();
+}
+
+void PromptListViewModel::onFolderChanged()
+{
+    m_foldersStale = true;
+    scheduleUpdate();
+}
+
+void PromptListViewModel::scheduleUpdate()
+{
+    if (m_updateScheduled) {
+        return;
+    }
+
+    m_updateScheduled = true;
+    QMetaObject::invokeMethod(this, &PromptListViewModel::applyPendingChanges, Qt::QueuedConnection);
+}
+
+void PromptListViewModel::applyPendingChanges()
+{
+    m_updateScheduled = false;
+    const QList<int> changed = std::exchange(m_changedPromptIds, {});
+    const QList<int> deleted = std::exchange(m_deletedPromptIds, {});
+    const QSet<int> changedFolders = std::exchange(m_changedFolderIds, {});
+    const bool foldersStale = std::exchange(m_foldersStale, false) || !changed.isEmpty() || !deleted.isEmpty();
+
+    // Folder counts follow every prompt change; the folder list is small
+    if (foldersStale) {
+        loadFolders();
+    }
+    if (m_refreshPending) {
+        return; // a full refresh is queued anyway
+    }
+
+    // A running search works on an older copy of the index, and a changed score can
+    // move a prompt anywhere in a ranking: both are simply searched again
+    const bool searching = !m_searchText.isEmpty();
+    if (changed.size() + deleted.size() > kMaxIncrementalChanges || !m_searchComplete ||
+        (searching && m_rankedSearch && (!changed.isEmpty() || !deleted.isEmpty()))) {
+        loadPrompts();
+        return;
+    }
+
+    // Decided before any row is touched. /pattern/ searches share one budget across
+    // the batch, like the search itself; a batch that can't be decided within it is
+    // searched again on the pool instead.
+    const QDeadlineTimer deadline(kRegexTimeoutMs);
+    QList<PromptRecord> prompts;
+    QList<bool> belongs;
+    prompts.reserve(changed.size());
+    belongs.reserve(changed.size());
+    for (int promptId : changed) {
+        const PromptRecord prompt = m_repository->promptRecordById(promptId);
+        bool timedOut = false;
+        belongs.append(prompt.isValid() && belongsInList(prompt, deadline, &timedOut));
+        if (timedOut) {
+            loadPrompts();
+            return;
+        }
+        prompts.append(prompt);
+    }
+
+    // Rows are looked up through one index built for the whole batch. Removals are
+    // collected and carried out last, bottom up, so the rows it found stay valid.
+    QHash<int, int> rowById = rowIndex();
+    QList<int> removedRows;
+    for (int promptId : deleted) {
+        const int row = rowById.value(promptId, -1);
+        if (row != -1) {
+            removedRows.append(row);
+        }
+    }
+
+    // Rows keep their place when they change; new ones are added at the end, as in
+    // the repository's listing
+    for (int i = 0; i < changed.size(); ++i) {
+        const int promptId = changed.at(i);
+        const int row = rowById.value(promptId, -1);
+        if (row != -1 && belongs.at(i)) {
+            m_rows[row] = Row{prompts.at(i)};
+            emit dataChanged(index(row), index(row));
+        } else if (row != -1) {
+            removedRows.append(row);
+        } else if (belongs.at(i)) {
+            rowById.insert(promptId, m_rows.size());
+            beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
+            m_rows.append(Row{prompts.at(i)});
+            endInsertRows();
+        }
+    }
+
+    std::sort(removedRows.begin(), removedRows.end(), std::greater<int>());
+    removedRows.erase(std::unique(removedRows.begin(), removedRows.end()), removedRows.end());
+    for (int row : std::as_const(removedRows)) {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rows.removeAt(row);
+        endRemoveRows();
+    }
+
+    if (!changedFolders.isEmpty()) {
+        for (int row = 0; row < m_rows.size(); ++row) {
+            if (changedFolders.contains(m_rows.at(row).prompt.folderId())) {
+                m_rows.at(row).displayReady = false;
+                emit dataChanged(index(row), index(row), {FolderNameRole});
+            }
+        }
+    }
+}
+
+// Same rules as loadPrompts(), applied to a single prompt. A /pattern/ is matched
+// until deadline; if it expires before a match is found, *timedOut is set and the
+// answer means nothing.
+bool PromptListViewModel::belongsInList(const PromptRecord &prompt, const QDeadlineTimer &deadline,
+                                        bool *timedOut) const
+{
+    *timedOut = false;
+    if (m_selectedFolderId > 0 && prompt.folderId() != m_selectedFolderId) {
+        return false;
+    }
+    if (m_searchText.isEmpty()) {
+        // Listings of uncategorized prompts; searches ignore that filter
+        return m_selectedFolderId != 0 || prompt.folderId() <= 0;
+    }
+
+    const QString content = prompt.isContentLoaded() ? prompt.content() : m_repository->getPromptContent(prompt.id());
+    if (RegexCache::isPatternQuery(m_searchText)) {
+        // Patterns are matched against the body only, as matchRegex() does
+        bool matched = false;
+        PromptSearchIndex::locate(RegexCache::compile(RegexCache::patternOf(m_searchText)), content, 1, &matched,
+                                  deadline);
+        *timedOut = !matched && deadline.hasExpired();
+        return matched;
+    }
+
+    const SearchQuery query = m_repository->parseSearchQuery(m_searchText);
+    const QString folded = TextFolding::fold(prompt.title() + QLatin1Char('\n') + content);
+
+    SearchQuery::Subject subject;
+    subject.folderId = prompt.folderId();
+    subject.createdAt = prompt.createdAt();
+    subject.updatedAt = prompt.updatedAt();
+    subject.foldedText = folded;
+    if (query.needsPlaceholders()) {
+        subject.hasPlaceholders = PlaceholderUtils::hasPlaceholders(content);
+    }
+    return query.matches(subject);
+}
+
+QHash<int, int> PromptListViewModel::rowIndex() const
+{
+    QHash<int, int> rowById;
+    rowById.reserve(m_rows.size());
+    for (int row = 0; row < m_rows.size(); ++row) {
+        rowById.insert(m_rows.at(row).prompt.id(), row);
+    }
+    return rowById;
 }
 
 void PromptListViewModel::loadPrompts()
 {
-    setIsLoading(true);
+    // Whatever is still running belongs to an older query
+    const quint64 generation = ++m_loadGeneration;
+    cancelSearch();
+    m_waitingForIndex = false;
     setErrorMessage("");
-    
-    beginResetModel();
-    
-    // Clear existing prompts
-    qDeleteAll(m_prompts);
-    m_prompts.clear();
-    
-    try {
-        if (!m_searchText.isEmpty()) {
-            // Search with optional folder filter
-            if (m_selectedFolderId > 0) {
-                m_prompts = m_repository->searchPromptsInFolder(m_searchText, m_selectedFolderId);
-            } else {
-                m_prompts = m_repository->searchPrompts(m_searchText);
-            }
-        } else {
-            // Load by folder or all
+    m_highlightQuery = SearchQuery();
+    m_highlightPattern = QRegularExpression();
+
+    if (m_searchText.isEmpty()) {
+        // Listings come straight from the repository's cache
+        QList<PromptRecord> prompts;
+        try {
             if (m_selectedFolderId > 0) {
-                m_prompts = m_repository->getPromptsByFolder(m_selectedFolderId);
+                prompts = m_repository->promptRecordsByFolder(m_selectedFolderId);
             } else if (m_selectedFolderId == 0) {
-                m_prompts = m_repository->getPromptsWithoutFolder();
+                prompts = m_repository->promptRecordsWithoutFolder();
             } else {
-                m_prompts = m_repository->getAllPrompts();
+                prompts = m_repository->allPromptRecords();
             }
+        } catch (const std::exception &e) {
+            setErrorMessage(QString("Failed to load prompts: %1").arg(e.what()));
+        }
+        applyPrompts(prompts);
+        setSearchComplete(true);
+        setIsLoading(false);
+        return;
+    }
+
+    m_searchClock.start();
+
+    // Text of the form /pattern/ is a regular expression matched against bodies
+    const bool regexMode = RegexCache::isPatternQuery(m_searchText);
+    QRegularExpression pattern;
+    if (regexMode) {
+        pattern = RegexCache::compile(RegexCache::patternOf(m_searchText));
+        if (!pattern.isValid()) {
+            setErrorMessage(QString("Invalid pattern: %1").arg(pattern.errorString()));
+            applyPrompts(QList<PromptRecord>());
+            setSearchComplete(true);
+            setIsLoading(false);
+            return;
+        }
+    }
+
+    PromptSearchIndex index;
+    SearchQuery query;
+    QString cacheKey;
+    try {
+        if (!regexMode) {
+            query = m_repository->parseSearchQuery(m_searchText, m_selectedFolderId);
+        }
+        m_highlightQuery = query;
+        m_highlightPattern = pattern;
+        // Query keys never start with a slash, so the two modes can't collide
+        cacheKey = QStringLiteral("%1|%2|%3|%4")
+                       .arg(regexMode ? m_searchText : query.key())
+                       .arg(m_selectedFolderId)
+                       .arg(m_rankedSearch ? 1 : 0)
+                       .arg(m_repository->generation());
+        if (const QList<PromptRecord> *cached = m_resultCache.object(cacheKey)) {
+            // Says nothing about how long a search takes, so it isn't sampled
+            m_searchClock.invalidate();
+            applyPrompts(*cached);
+            setSearchComplete(true);
+            setIsLoading(false);
+            return;
         }
+        if (!m_repository->prepareSearchIndex()) {
+            // Bodies are still being read or indexed off this thread; the previous
+            // results stay up until onSearchIndexReady() runs the search
+            m_searchClock.invalidate();
+            m_waitingForIndex = true;
+            setSearchComplete(false);
+            setIsLoading(true);
+            return;
+        }
+        index = m_repository->searchIndex();
     } catch (const std::exception &e) {
         setErrorMessage(QString("Failed to load prompts: %1").arg(e.what()));
+        applyPrompts(QList<PromptRecord>());
+        setSearchComplete(true);
+        setIsLoading(false);
+        return;
     }
-    
-    endResetModel();
+
+    setIsLoading(true);
+    setSearchComplete(false);
+    m_searchHasResults = false;
+
+    const bool ranked = m_rankedSearch && !regexMode;
+    const bool refine = !ranked && !regexMode && m_lastSearch.valid &&
+                        m_lastSearch.indexGeneration == index.generation() && query.refines(m_lastSearch.query);
+    const QList<int> previousIds = refine ? m_lastSearch.promptIds : QList<int>();
+    // Ranked results are cut off at a limit, so they can't seed a refinement
+    m_runningSearch = SearchResultSet{query, index.generation(), {}, !ranked && !regexMode};
+    m_runningCacheKey = cacheKey;
+    m_searchTimedOut = std::make_shared<std::atomic<bool>>(false);
+
+    const int folderId = m_selectedFolderId;
+    const std::shared_ptr<std::atomic<bool>> timedOut = m_searchTimedOut;
+    QFuture<PromptRecord> future = QtConcurrent::run(&m_searchPool,
+        [index, query, ranked, refine, previousIds, regexMode, pattern, folderId, timedOut](
+            QPromise<PromptRecord> &promise) {
+            if (promise.isCanceled()) {
+                return;
+            }
+            const auto cancelled = [&promise]() { return promise.isCanceled(); };
+            const auto sink = [&promise](const QList<PromptRecord> &batch) {
+                promise.addResults(batch);
+            };
+            if (regexMode) {
+                // Matched in parallel on the global pool; this worker only waits
+                bool expired = false;
+                const QList<PromptSearchIndex::RegexHit> hits = index.matchRegex(
+                    pattern, folderId, QThreadPool::globalInstance(), QDeadlineTimer(kRegexTimeoutMs), &expired,
+                    cancelled);
+                *timedOut = expired;
+                QList<PromptRecord> records;
+                records.reserve(hits.size());
+                for (const PromptSearchIndex::RegexHit &hit : hits) {
+                    records.append(hit.record);
+                }
+                promise.addResults(records);
+            } else if (ranked) {
+                // Ranking needs every hit before the first one is known
+                promise.addResults(index.rank(query, kRankedResultLimit, cancelled));
+            } else if (refine) {
+                index.refine(query, previousIds, sink, cancelled, QThreadPool::globalInstance());
+            } else {
+                index.search(query, sink, cancelled, QThreadPool::globalInstance());
+            }
+        });
+
+    // Signals arrive on the GUI thread; the watcher coalesces batches that come in
+    // faster than the event loop runs
+    m_searchWatcher = new QFutureWatcher<PromptRecord>(this);
+    connect(m_searchWatcher, &QFutureWatcherBase::resultsReadyAt, this, [this, generation](int begin, int end) {
+        appendSearchResults(generation, begin, end);
+    });
+    connect(m_searchWatcher, &QFutureWatcherBase::finished, this, [this, generation]() {
+        finishSearch(generation);
+    });
+    m_searchWatcher->setFuture(future);
+}
+
+void PromptListViewModel::onSearchIndexReady()
+{
+    if (m_waitingForIndex) {
+        loadPrompts();
+    }
+}
+
+void PromptListViewModel::appendSearchResults(quint64 generation, int begin, int end)
+{
+    if (generation != m_loadGeneration || !m_searchWatcher) {
+        return;
+    }
+
+    const QFuture<PromptRecord> future = m_searchWatcher->future();
+    if (m_runningSearch.valid) {
+        for (int i = begin; i < end; ++i) {
+            m_runningSearch.promptIds.append(future.resultAt(i).id());
+        }
+    }
+
+    if (!m_searchHasResults) {
+        // Keep showing the previous results until there is something to replace them
+        m_searchHasResults = true;
+        QList<PromptRecord> prompts;
+        prompts.reserve(end - begin);
+        for (int i = begin; i < end; ++i) {
+            prompts.append(future.resultAt(i));
+        }
+        applyPrompts(prompts);
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + (end - begin) - 1);
+    for (int i = begin; i < end; ++i) {
+        m_rows.append(Row{future.resultAt(i)});
+    }
+    endInsertRows();
+}
+
+void PromptListViewModel::finishSearch(quint64 generation)
+{
+    if (generation != m_loadGeneration) {
+        return;
+    }
+
+    recordSearchLatency(true);
+    if (!m_searchHasResults) {
+        applyPrompts(QList<PromptRecord>());
+    }
+    // Only a search that ran to the end has every match a refinement could need
+    if (m_runningSearch.valid) {
+        m_lastSearch = m_runningSearch;
+    }
+    m_runningSearch = SearchResultSet();
+    // Partial results would hide the rest for good if they were cached
+    if (m_searchTimedOut && *m_searchTimedOut) {
+        setErrorMessage(QString("Pattern search stopped after %1 ms; results are incomplete").arg(kRegexTimeoutMs));
+    } else {
+        m_resultCache.insert(m_runningCacheKey, new QList<PromptRecord>(m_searchWatcher->future().results()));
+    }
+    m_runningCacheKey.clear();
+    m_searchTimedOut.reset();
+    m_searchWatcher->deleteLater();
+    m_searchWatcher = nullptr;
+    setSearchComplete(true);
     setIsLoading(false);
 }
 
+// A cancelled search only shows it takes at least that long. It still counts when
+// that is above the average, or a library whose searches are always cut short by
+// the next keystroke would never slow the debounce down.
+void PromptListViewModel::recordSearchLatency(bool finished)
+{
+    if (!m_searchClock.isValid()) {
+        return;
+    }
+    const double elapsed = m_searchClock.elapsed();
+    m_searchClock.invalidate();
+    if (!finished && elapsed <= m_searchLatency) {
+        return;
+    }
+
+    m_searchLatency = m_searchLatency > 0.0
+        ? m_searchLatency + kLatencySmoothing * (elapsed - m_searchLatency)
+        : elapsed;
+    const int interval = m_searchLatency < kImmediateLatencyMs
+        ? 0
+        : qBound(kMinDebounceMs, qRound(m_searchLatency * kDebounceLatencyFactor), kMaxDebounceMs);
+    m_searchTimer->setInterval(interval);
+    emit searchTimingChanged();
+}
+
+void PromptListViewModel::cancelSearch()
+{
+    if (!m_searchWatcher) {
+        return;
+    }
+
+    recordSearchLatency(false);
+    m_searchWatcher->disconnect(this);
+    m_searchWatcher->cancel();
+    m_searchWatcher->deleteLater();
+    m_searchWatcher = nullptr;
+}
+
+void PromptListViewModel::applyPrompts(const QList<PromptRecord> &prompts)
+{
+    beginResetModel();
+    m_rows.clear();
+    m_rows.reserve(prompts.size());
+    for (const PromptRecord &prompt : prompts) {
+        m_rows.append(Row{prompt});
+    }
+    endResetModel();
+}
+
+void PromptListViewModel::prepareDisplay(const Row &row) const
+{
+    if (row.displayReady) {
+        return;
+    }
+
+    // Repositories may defer reading bodies; only rows actually shown pay for it
+    const PromptRecord &prompt = row.prompt;
+    const QString content = prompt.isContentLoaded() ? prompt.content() : m_repository->getPromptContent(prompt.id());
+    // Collapsing whitespace can only shorten the text, so a bounded prefix is enough
+    row.preview = content.left(kPreviewLength * 4).simplified().left(kPreviewLength);
+    row.folderName = m_folderNames.value(prompt.folderId());
+
+    // Matches are only located for rows on screen, never for the whole result set
+    QList<PromptSearchIndex::Span> matches;
+    if (m_highlightPattern.isValid() && !m_highlightPattern.pattern().isEmpty()) {
+        matches = PromptSearchIndex::locate(m_highlightPattern, content, kMaxHighlights, nullptr,
+                                            QDeadlineTimer(kHighlightTimeoutMs));
+    } else if (!m_highlightQuery.isEmpty()) {
+        matches = PromptSearchIndex::locate(m_highlightQuery, content, kMaxHighlights);
+    }
+    const PromptSearchIndex::Snippet snippet = PromptSearchIndex::snippet(content, matches, kPreviewLength);
+    // Escaped and marked up here, so delegates bind it as is
+    row.snippet.clear();
+    if (!snippet.text.isEmpty()) {
+        int position = 0;
+        for (const PromptSearchIndex::Span &span : snippet.highlights) {
+            row.snippet += snippet.text.mid(position, span.start - position).toHtmlEscaped();
+            row.snippet += QLatin1String("<b>") + snippet.text.mid(span.start, span.length).toHtmlEscaped()
+                           + QLatin1String("</b>");
+            position = span.start + span.length;
+        }
+        row.snippet += snippet.text.mid(position).toHtmlEscaped();
+    }
+    row.displayReady = true;
+}
+
 void PromptListViewModel::loadFolders()
 {
     // Clear existing folders
@@ -204,7 +729,14 @@ void PromptListViewModel::loadFolders()
     m_folders.clear();
     
     try {
+        // Counts are maintained by the repository, so these are cheap lookups
         m_folders = m_repository->getFoldersWithCounts();
+        m_folderNames.clear();
+        for (const Folder *folder : std::as_const(m_folders)) {
+            m_folderNames.insert(folder->id(), folder->name());
+        }
+        m_totalCount = m_repository->getPromptCount();
+        m_uncategorizedCount = m_repository->getPromptCountByFolder(0);
         emit foldersChanged();
     } catch (const std::exception &e) {
         setErrorMessage(QString("Failed to load folders: %1").arg(e.what()));
@@ -219,6 +751,14 @@ void PromptListViewModel::setIsLoading(bool loading)
     }
 }
 
+void PromptListViewModel::setSearchComplete(bool complete)
+{
+    if (m_searchComplete != complete) {
+        m_searchComplete = complete;
+        emit searchCompleteChanged();
+    }
+}
+
 void PromptListViewModel::setErrorMessage(const QString &message)
 {
     if (m_errorMessage != message) {
@@ -4,8 +4,18 @@
 #include <QObject>
 #include <QAbstractListModel>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QCache>
+#include <memory>
+#include <atomic>
 #include "../models/prompt.h"
 #include "../models/folder.h"
+#include "../models/promptrecord.h"
+#include "../utils/searchquery.h"
 
 class PromptRepository;
 
@@ -13,10 +23,16 @@ class PromptListViewModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QString searchText READ searchText WRITE setSearchText NOTIFY searchTextChanged)
+    Q_PROPERTY(bool rankedSearch READ rankedSearch WRITE setRankedSearch NOTIFY rankedSearchChanged)
     Q_PROPERTY(int selectedFolderId READ selectedFolderId WRITE setSelectedFolderId NOTIFY selectedFolderIdChanged)
     Q_PROPERTY(QList<QObject*> folders READ folders NOTIFY foldersChanged)
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY foldersChanged)
+    Q_PROPERTY(int uncategorizedCount READ uncategorizedCount NOTIFY foldersChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(bool searchComplete READ searchComplete NOTIFY searchCompleteChanged)
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
+    Q_PROPERTY(int searchDebounceInterval READ searchDebounceInterval NOTIFY searchTimingChanged)
+    Q_PROPERTY(double searchLatency READ searchLatency NOTIFY searchTimingChanged)
 
 public:
     enum PromptRoles {
@@ -27,10 +43,14 @@ public:
         FolderNameRole,
         CreatedAtRole,
         UpdatedAtRole,
-        PromptObjectRole
+        PromptObjectRole,
+        PreviewRole,
+        SnippetRole    // while searching: the body around the best match as StyledText,
+                       // matches in <b>; else empty
     };
 
     explicit PromptListViewModel(PromptRepository *repository, QObject *parent = nullptr);
+    ~PromptListViewModel();
 
     // QAbstractListModel interface
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -40,47 +60,141 @@ public:
     // Properties
     QString searchText() const { return m_searchText; }
     void setSearchText(const QString &searchText);
+
+    // Order search results by relevance instead of listing order
+    bool rankedSearch() const { return m_rankedSearch; }
+    void setRankedSearch(bool ranked);
     
     int selectedFolderId() const { return m_selectedFolderId; }
     void setSelectedFolderId(int folderId);
     
     QList<QObject*> folders() const;
+    int totalCount() const { return m_totalCount; }
+    int uncategorizedCount() const { return m_uncategorizedCount; }
     bool isLoading() const { return m_isLoading; }
+    // False while search results are still arriving
+    bool searchComplete() const { return m_searchComplete; }
     QString errorMessage() const { return m_errorMessage; }
+    // Diagnostics: how long typing is debounced before a search starts, and the
+    // moving average of how long searches took (ms) that it is derived from
+    int searchDebounceInterval() const { return m_searchTimer->interval(); }
+    double searchLatency() const { return m_searchLatency; }
 
     // Public methods
     Q_INVOKABLE void refreshData();
     Q_INVOKABLE void deletePrompt(int promptId);
     Q_INVOKABLE void duplicatePrompt(int promptId);
     Q_INVOKABLE Prompt* getPromptById(int promptId);
+    Q_INVOKABLE QString getPromptContent(int promptId);
 
 signals:
     void searchTextChanged();
+    void rankedSearchChanged();
     void selectedFolderIdChanged();
     void foldersChanged();
     void isLoadingChanged();
+    void searchCompleteChanged();
     void errorMessageChanged();
+    void searchTimingChanged();
     void promptDeleted(int promptId);
     void promptDuplicated();
 
 private slots:
     void onSearchTimerTimeout();
     void onDataChanged();
+    void onPromptChanged(Prompt *prompt);
+    void onPromptDeleted(int promptId);
+    void onFolderUpdated(Folder *folder);
+    void onFolderDeleted(int folderId);
+    void onFolderChanged();
+    void onSearchIndexReady();
 
 private:
     void loadPrompts();
     void loadFolders();
+    void applyPrompts(const QList<PromptRecord> &prompts);
+    void appendSearchResults(quint64 generation, int begin, int end);
+    void finishSearch(quint64 generation);
+    void cancelSearch();
+    void recordSearchLatency(bool finished);
+    void setSearchComplete(bool complete);
+    void scheduleUpdate();
+    void applyPendingChanges();
+    bool belongsInList(const PromptRecord &prompt, const QDeadlineTimer &deadline, bool *timedOut) const;
+    QHash<int, int> rowIndex() const;
+
+    // One list row. Display values are derived on first access and kept until the
+    // row's record or folder changes.
+    struct Row {
+        PromptRecord prompt;
+        mutable QString preview;
+        mutable QString folderName;
+        mutable QString snippet;
+        mutable bool displayReady = false;
+    };
+    void prepareDisplay(const Row &row) const;
     void setIsLoading(bool loading);
     void setErrorMessage(const QString &message);
     
     PromptRepository *m_repository;
-    QList<Prompt*> m_prompts;
+    QList<Row> m_rows;
     QList<Folder*> m_folders;
+    QHash<int, QString> m_folderNames;
+    int m_totalCount;
+    int m_uncategorizedCount;
     QString m_searchText;
+    bool m_rankedSearch;
     int m_selectedFolderId;
     bool m_isLoading;
+    bool m_refreshPending;
+
+    // Repository changes are queued and applied together as row operations, so a
+    // burst of external edits costs one pass; past a limit it is a full refresh
+    bool m_updateScheduled;
+    QList<int> m_changedPromptIds;
+    QList<int> m_deletedPromptIds;
+    QSet<int> m_changedFolderIds; // renamed or deleted, rows show a stale folder name
+    bool m_foldersStale;
     QString m_errorMessage;
+    // The debounce follows measured search latency: immediate when searches are
+    // cheap, longer when they are slow, so keystrokes in a burst collapse into one
     QTimer *m_searchTimer;
+    QElapsedTimer m_searchClock; // running while a search is
+    double m_searchLatency;
+
+    // Searches run on a single worker against a copy of the repository's search
+    // index and report matches in batches. Every load bumps the generation, so
+    // results of an older query are dropped even if they arrive after it was cancelled.
+    QThreadPool m_searchPool;
+    QFutureWatcher<PromptRecord> *m_searchWatcher;
+    quint64 m_loadGeneration;
+    bool m_searchComplete;
+    bool m_searchHasResults; // the first batch replaces the previous list
+    bool m_waitingForIndex;  // the search runs again once the repository has indexed
+
+    // Matches of a plain search, in listing order. The last completed one is kept so
+    // a query that refines it (the user typed on) only re-checks those prompts, as
+    // long as the index generation shows nothing changed in between.
+    struct SearchResultSet {
+        SearchQuery query;
+        quint64 indexGeneration = 0;
+        QList<int> promptIds;
+        bool valid = false;
+    };
+    SearchResultSet m_runningSearch;
+    SearchResultSet m_lastSearch;
+
+    // Results of recent searches, so flipping between folders and recurring queries
+    // doesn't search again. Keyed by query, folder, mode and repository generation;
+    // entries from before a change are never hit again and age out.
+    QCache<QString, QList<PromptRecord>> m_resultCache;
+    QString m_runningCacheKey;
+    // What the current search matched, for highlighting rows as they are shown.
+    // Only one of them is set, depending on the mode.
+    SearchQuery m_highlightQuery;
+    QRegularExpression m_highlightPattern;
+    // Set by the worker when a pattern search ran out of time
+    std::shared_ptr<std::atomic<bool>> m_searchTimedOut;
 };
 
 #endif // PROMPTLISTVIEWMODEL_H
\ No newline at end of file
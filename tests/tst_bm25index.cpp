@@ -0,0 +1,166 @@
+#include <QtTest>
+#include "utils/bm25index.h"
+
+class TestBm25Index : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void sortedBestFirst();
+    void limitKeepsBest_data();
+    void limitKeepsBest();
+    void filterSkipsDocuments();
+    void lastTermMatchesPrefix();
+    void titleOutweighsBody();
+    void removeRestoresScores();
+
+private:
+    static QHash<int, double> scores(const QList<Bm25Index::Hit> &hits);
+
+    Bm25Index m_index;
+};
+
+QHash<int, double> TestBm25Index::scores(const QList<Bm25Index::Hit> &hits)
+{
+    QHash<int, double> result;
+    for (const Bm25Index::Hit &hit : hits) {
+        result.insert(hit.docId, hit.score);
+    }
+    return result;
+}
+
+// A few hundred documents drawn from a small vocabulary, so most queries match
+// many of them with plenty of distinct scores
+void TestBm25Index::initTestCase()
+{
+    const QStringList words = {"summary", "report", "draft", "email", "review",
+                               "code", "bug", "plan", "menu", "reply", "sum"};
+    quint32 seed = 12345;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return int((seed >> 16) % quint32(bound));
+    };
+
+    for (int docId = 1; docId <= 300; ++docId) {
+        QStringList title;
+        QStringList body;
+        for (int i = next(3) + 1; i > 0; --i) {
+            title << words.at(next(words.size()));
+        }
+        for (int i = next(20) + 5; i > 0; --i) {
+            body << words.at(next(words.size()));
+        }
+        m_index.insert(docId, Bm25Index::analyze(title.join(' '), body.join(' ')));
+    }
+}
+
+void TestBm25Index::sortedBestFirst()
+{
+    const QList<Bm25Index::Hit> hits = m_index.topK(u"summary bug", 1000);
+    QVERIFY(hits.size() > 50);
+    for (int i = 1; i < hits.size(); ++i) {
+        QVERIFY(hits.at(i - 1).score >= hits.at(i).score);
+    }
+    QVERIFY(m_index.topK(u"summary bug", 0).isEmpty());
+    QVERIFY(m_index.topK(u"nothing", 10).isEmpty());
+}
+
+void TestBm25Index::limitKeepsBest_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<int>("limit");
+
+    QTest::newRow("one") << "report" << 1;
+    QTest::newRow("few") << "draft email" << 5;
+    QTest::newRow("page") << "code review bug" << 20;
+    QTest::newRow("prefix") << "plan su" << 50;
+}
+
+// The bounded heap has to keep exactly the best limit scores of the full ranking
+void TestBm25Index::limitKeepsBest()
+{
+    QFETCH(QString, query);
+    QFETCH(int, limit);
+
+    const QList<Bm25Index::Hit> all = m_index.topK(query, 1000);
+    const QList<Bm25Index::Hit> best = m_index.topK(query, limit);
+    QVERIFY(all.size() > limit);
+    QCOMPARE(best.size(), limit);
+
+    const QHash<int, double> allScores = scores(all);
+    for (int i = 0; i < limit; ++i) {
+        QCOMPARE(best.at(i).score, all.at(i).score);
+        QCOMPARE(allScores.value(best.at(i).docId), best.at(i).score);
+    }
+}
+
+void TestBm25Index::filterSkipsDocuments()
+{
+    auto even = [](int docId) { return docId % 2 == 0; };
+    const QList<Bm25Index::Hit> filtered = m_index.topK(u"draft", 10, even);
+    QCOMPARE(filtered.size(), 10);
+
+    QList<Bm25Index::Hit> expected;
+    for (const Bm25Index::Hit &hit : m_index.topK(u"draft", 1000)) {
+        if (even(hit.docId)) {
+            expected.append(hit);
+        }
+    }
+    for (int i = 0; i < filtered.size(); ++i) {
+        QVERIFY(even(filtered.at(i).docId));
+        QCOMPARE(filtered.at(i).score, expected.at(i).score);
+    }
+}
+
+void TestBm25Index::lastTermMatchesPrefix()
+{
+    Bm25Index index;
+    index.insert(1, Bm25Index::analyze(u"Summary", u"weekly report"));
+    index.insert(2, Bm25Index::analyze(u"Summer", u"holiday plans"));
+    index.insert(3, Bm25Index::analyze(u"Report", u"nothing else"));
+
+    const QHash<int, double> typing = scores(index.topK(u"summ", 10));
+    QCOMPARE(typing.size(), 2);
+    QVERIFY(typing.contains(1) && typing.contains(2));
+
+    // Only the last term is a prefix; "summ" here has to match a whole word
+    const QList<Bm25Index::Hit> hits = index.topK(u"summ plans", 10);
+    QCOMPARE(hits.size(), 1);
+    QCOMPARE(hits.constFirst().docId, 2);
+}
+
+void TestBm25Index::titleOutweighsBody()
+{
+    Bm25Index index;
+    index.insert(1, Bm25Index::analyze(u"alpha", u"one two three"));
+    index.insert(2, Bm25Index::analyze(u"three", u"one two alpha"));
+
+    const QList<Bm25Index::Hit> hits = index.topK(u"alpha", 10);
+    QCOMPARE(hits.size(), 2);
+    QCOMPARE(hits.at(0).docId, 1);
+    QVERIFY(hits.at(0).score > hits.at(1).score);
+}
+
+void TestBm25Index::removeRestoresScores()
+{
+    Bm25Index index;
+    index.insert(1, Bm25Index::analyze(u"draft", u"a reply to the email"));
+    index.insert(2, Bm25Index::analyze(u"email", u"draft of a reply"));
+    const QHash<int, double> before = scores(index.topK(u"draft email", 10));
+
+    const Bm25Index::Document extra = Bm25Index::analyze(u"draft draft", u"another email");
+    index.insert(3, extra);
+    QCOMPARE(index.topK(u"draft email", 10).size(), 3);
+    index.remove(3, extra);
+
+    QVERIFY(!index.contains(3));
+    const QHash<int, double> after = scores(index.topK(u"draft email", 10));
+    QCOMPARE(after.size(), before.size());
+    for (auto it = before.cbegin(); it != before.cend(); ++it) {
+        QVERIFY(qFuzzyCompare(after.value(it.key()), it.value()));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestBm25Index)
+#include "tst_bm25index.moc"
@@ -0,0 +1,378 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QStandardPaths>
+#include <memory>
+#include "repository/markdownpromptrepository.h"
+
+class TestMarkdownPromptRepository : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void lazyListsCarryBodies();
+    void reloadKeepsIds();
+    void renameWhileClosedKeepsId();
+    void ambiguousRenamesGetNewIds();
+    void sessionRenameBeatsSnapshot();
+    void unchangedVaultKeepsSnapshot();
+    void snapshotCoversQueuedSaves();
+    void folderRenameFollowsQueuedSaves();
+    void folderRenameRefusesTakenName();
+    void searchIndexBuildsInBackground();
+
+private:
+    void writeFile(const QString &relativePath, const QString &title, const QString &body);
+    std::unique_ptr<MarkdownPromptRepository> openVault(bool lazy);
+    void reload(MarkdownPromptRepository *repository);
+    static QHash<QString, int> idsByTitle(MarkdownPromptRepository *repository);
+
+    std::unique_ptr<QTemporaryDir> m_vault;
+    QTemporaryDir m_scratch; // an empty vault to open before the real one
+};
+
+void TestMarkdownPromptRepository::initTestCase()
+{
+    // Snapshots go to the app data location; keep them out of the real one
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestMarkdownPromptRepository::init()
+{
+    m_vault = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_vault->isValid());
+}
+
+void TestMarkdownPromptRepository::cleanup()
+{
+    QFile::remove(PromptIndexSnapshot::defaultLocation(m_vault->path()));
+    m_vault.reset();
+}
+
+void TestMarkdownPromptRepository::writeFile(const QString &relativePath, const QString &title, const QString &body)
+{
+    const QString path = m_vault->filePath(relativePath);
+    QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QString("---\ntitle: %1\ncreatedAt: 2026-01-01T12:00:00\nupdatedAt: 2026-01-01T12:00:00\n---\n%2")
+                   .arg(title, body)
+                   .toUtf8());
+}
+
+std::unique_ptr<MarkdownPromptRepository> TestMarkdownPromptRepository::openVault(bool lazy)
+{
+    // Lazy mode takes effect on the next reload, which moving to the vault is
+    auto repository = std::make_unique<MarkdownPromptRepository>(m_scratch.path(), 2);
+    repository->setLazyLoading(lazy);
+    repository->setRootPath(m_vault->path());
+    return repository;
+}
+
+// What the watcher does when a batch of external changes is too large to apply one
+// by one, minus the wait for it. The reload waits for the writer to go idle.
+void TestMarkdownPromptRepository::reload(MarkdownPromptRepository *repository)
+{
+    QSignalSpy reloaded(repository, &PromptRepository::dataChanged);
+    repository->setBulkChangeThreshold(0);
+    QVERIFY(QMetaObject::invokeMethod(repository, "onDirectoriesChanged", Qt::DirectConnection,
+                                      Q_ARG(QStringList, QStringList{QDir(m_vault->path()).absolutePath()})));
+    QTRY_COMPARE(reloaded.count(), 1);
+}
+
+QHash<QString, int> TestMarkdownPromptRepository::idsByTitle(MarkdownPromptRepository *repository)
+{
+    QHash<QString, int> ids;
+    for (const PromptRecord &record : repository->allPromptRecords()) {
+        ids.insert(record.title(), record.id());
+    }
+    return ids;
+}
+
+// Lazy loading defers bodies for records only; the Prompt* API hands out whole prompts
+void TestMarkdownPromptRepository::lazyListsCarryBodies()
+{
+    writeFile("a.md", "Alpha", "First body");
+    writeFile("Coding/b.md", "Beta", "Second body");
+    writeFile("Coding/c.md", "Gamma", "Third body");
+
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const int codingId = repository->folderIdByName("Coding");
+    QVERIFY(codingId > 0);
+    for (const PromptRecord &record : repository->allPromptRecords()) {
+        QVERIFY(!record.isContentLoaded());
+    }
+
+    QHash<QString, QString> bodies;
+    const QList<Prompt*> inFolder = repository->getPromptsByFolder(codingId);
+    QCOMPARE(inFolder.size(), 2);
+    for (Prompt *prompt : inFolder) {
+        QVERIFY(prompt->isContentLoaded());
+        bodies.insert(prompt->title(), prompt->content());
+    }
+    qDeleteAll(inFolder);
+    QCOMPARE(bodies.value("Beta"), QString("Second body"));
+    QCOMPARE(bodies.value("Gamma"), QString("Third body"));
+    // Only that folder was read
+    QCOMPARE(repository->allPromptRecords().size(), 3);
+    for (const PromptRecord &record : repository->allPromptRecords()) {
+        QCOMPARE(record.isContentLoaded(), record.title() != "Alpha");
+    }
+
+    const QList<Prompt*> all = repository->getAllPrompts();
+    QCOMPARE(all.size(), 3);
+    for (Prompt *prompt : all) {
+        QVERIFY(prompt->isContentLoaded());
+        QVERIFY(prompt->content().endsWith("body"));
+    }
+    qDeleteAll(all);
+
+    const QList<PromptWithFolder*> withFolders = repository->getPromptsWithFolders();
+    QCOMPARE(withFolders.size(), 3);
+    for (PromptWithFolder *entry : withFolders) {
+        QVERIFY(entry->prompt()->isContentLoaded());
+        QVERIFY(!entry->prompt()->content().isEmpty());
+        delete entry->prompt();
+    }
+    qDeleteAll(withFolders);
+}
+
+void TestMarkdownPromptRepository::reloadKeepsIds()
+{
+    writeFile("a.md", "Alpha", "First body");
+    writeFile("Coding/b.md", "Beta", "Second body");
+
+    QHash<QString, int> before;
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+        before = idsByTitle(repository.get());
+        writeFile("c.md", "Gamma", "Third body");
+        reload(repository.get());
+        const QHash<QString, int> after = idsByTitle(repository.get());
+        QCOMPARE(after.size(), 3);
+        QCOMPARE(after.value("Alpha"), before.value("Alpha"));
+        QCOMPARE(after.value("Beta"), before.value("Beta"));
+        before = after;
+    }
+
+    // And across sessions, through the snapshot
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(false);
+    QCOMPARE(idsByTitle(repository.get()), before);
+}
+
+// Same front matter and size at a new path: the file was moved, not replaced
+void TestMarkdownPromptRepository::renameWhileClosedKeepsId()
+{
+    writeFile("a.md", "Alpha", "First body");
+    writeFile("b.md", "Beta", "Second body");
+    int alphaId = -1;
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+        alphaId = idsByTitle(repository.get()).value("Alpha");
+    }
+    QVERIFY(alphaId > 0);
+
+    QVERIFY(QDir().mkpath(m_vault->filePath("Writing")));
+    QVERIFY(QFile::rename(m_vault->filePath("a.md"), m_vault->filePath("Writing/moved.md")));
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    QCOMPARE(idsByTitle(repository.get()).value("Alpha"), alphaId);
+    QCOMPARE(repository->promptRecordById(alphaId).folderId(), repository->folderIdByName("Writing"));
+}
+
+// Without front matter every file hashes the same; two such files renamed at once
+// can't be told apart and must not swap IDs
+void TestMarkdownPromptRepository::ambiguousRenamesGetNewIds()
+{
+    const auto writeBare = [this](const QString &name, const QByteArray &body) {
+        QFile file(m_vault->filePath(name));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(body);
+    };
+    writeBare("x.md", "same size one");
+    writeBare("y.md", "same size two");
+    QList<int> oldIds;
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+        oldIds = idsByTitle(repository.get()).values();
+    }
+    QCOMPARE(oldIds.size(), 2);
+
+    QVERIFY(QFile::rename(m_vault->filePath("x.md"), m_vault->filePath("p.md")));
+    QVERIFY(QFile::rename(m_vault->filePath("y.md"), m_vault->filePath("q.md")));
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const QHash<QString, int> ids = idsByTitle(repository.get());
+    QCOMPARE(ids.size(), 2);
+    for (int promptId : ids) {
+        QVERIFY(!oldIds.contains(promptId));
+    }
+}
+
+// The snapshot still credits a.md with the prompt renamed away from it in this
+// session; the new file that took its place must not take the ID along
+void TestMarkdownPromptRepository::sessionRenameBeatsSnapshot()
+{
+    writeFile("a.md", "Alpha", "First body");
+    writeFile("z.md", "Zulu", "Last body");
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    }
+
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const QHash<QString, int> before = idsByTitle(repository.get());
+    const int alphaId = before.value("Alpha");
+    QVERIFY(alphaId > 0);
+
+    std::unique_ptr<Prompt> prompt(repository->getPromptById(alphaId));
+    QVERIFY(prompt);
+    // Listed after a.md, so the snapshot's claim on the ID is seen first
+    prompt->setTitle("zeta");
+    QVERIFY(repository->savePrompt(prompt.get()));
+    QTRY_VERIFY(QFile::exists(m_vault->filePath("zeta.md")) && !QFile::exists(m_vault->filePath("a.md")));
+
+    writeFile("a.md", "Another alpha", "A new file at the old path");
+    reload(repository.get());
+
+    const QHash<QString, int> after = idsByTitle(repository.get());
+    QCOMPARE(after.size(), 3);
+    QCOMPARE(after.value("zeta"), alphaId);
+    QCOMPARE(after.value("Zulu"), before.value("Zulu"));
+    QVERIFY(after.value("Another alpha") > 0);
+    QVERIFY(after.value("Another alpha") != alphaId);
+    QVERIFY(after.value("Another alpha") != before.value("Zulu"));
+}
+
+// Reading every body, as a non-lazy load does, is no reason to rewrite the snapshot
+void TestMarkdownPromptRepository::unchangedVaultKeepsSnapshot()
+{
+    writeFile("a.md", "Alpha", "First body");
+    writeFile("Coding/b.md", "Beta", "Second body");
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(false);
+    }
+
+    const QString snapshotPath = PromptIndexSnapshot::defaultLocation(m_vault->path());
+    const QDateTime old(QDate(2020, 1, 1), QTime(0, 0));
+    {
+        QFile snapshot(snapshotPath);
+        QVERIFY(snapshot.open(QIODevice::ReadWrite));
+        QVERIFY(snapshot.setFileTime(old, QFileDevice::FileModificationTime));
+    }
+
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(false);
+        QCOMPARE(repository->getPromptCount(), 2);
+    }
+    QCOMPARE(QFileInfo(snapshotPath).lastModified(), old);
+
+    // A file that changed does get it rewritten
+    writeFile("a.md", "Alpha", "First body, edited");
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(false);
+    }
+    QVERIFY(QFileInfo(snapshotPath).lastModified() != old);
+}
+
+// Saves still queued when the snapshot is taken have no size or mtime yet; the writer
+// fills them in, so the next start needn't open those files
+void TestMarkdownPromptRepository::snapshotCoversQueuedSaves()
+{
+    writeFile("a.md", "Alpha", "First body");
+    {
+        const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+        Prompt prompt;
+        prompt.setTitle("Saved");
+        prompt.setContent("Written in the background");
+        QVERIFY(repository->savePrompt(&prompt));
+        std::unique_ptr<Prompt> alpha(repository->getPromptById(idsByTitle(repository.get()).value("Alpha")));
+        alpha->setContent("Edited");
+        QVERIFY(repository->savePrompt(alpha.get()));
+    }
+
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    QCOMPARE(repository->lastScanTimings().fileCount, 2);
+    QCOMPARE(repository->lastScanTimings().reusedCount, 2);
+    QCOMPARE(repository->getPromptContent(idsByTitle(repository.get()).value("Saved")),
+             QString("Written in the background"));
+    QCOMPARE(repository->getPromptContent(idsByTitle(repository.get()).value("Alpha")), QString("Edited"));
+}
+
+// The rename is queued behind the save into the old directory instead of waiting
+// for it, and the save after it lands in the new one
+void TestMarkdownPromptRepository::folderRenameFollowsQueuedSaves()
+{
+    writeFile("Drafts/a.md", "Alpha", "First body");
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const int folderId = repository->folderIdByName("Drafts");
+    QVERIFY(folderId > 0);
+
+    std::unique_ptr<Prompt> alpha(repository->getPromptById(idsByTitle(repository.get()).value("Alpha")));
+    alpha->setContent("Edited before");
+    QVERIFY(repository->savePrompt(alpha.get()));
+
+    std::unique_ptr<Folder> folder(repository->getFolderById(folderId));
+    folder->setName("Final");
+    QVERIFY(repository->saveFolder(folder.get()));
+    QCOMPARE(repository->folderIdByName("Final"), folderId);
+
+    alpha->setContent("Edited after");
+    QVERIFY(repository->savePrompt(alpha.get()));
+
+    QTRY_VERIFY(!QFileInfo::exists(m_vault->filePath("Drafts")));
+    const auto body = [this]() {
+        QFile file(m_vault->filePath("Final/a.md"));
+        return file.open(QIODevice::ReadOnly) ? QString::fromUtf8(file.readAll()) : QString();
+    };
+    QTRY_VERIFY(body().endsWith("Edited after"));
+}
+
+void TestMarkdownPromptRepository::folderRenameRefusesTakenName()
+{
+    writeFile("Drafts/a.md", "Alpha", "First body");
+    writeFile("Final/b.md", "Beta", "Second body");
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const int folderId = repository->folderIdByName("Drafts");
+
+    std::unique_ptr<Folder> folder(repository->getFolderById(folderId));
+    folder->setName("Final");
+    QVERIFY(!repository->saveFolder(folder.get()));
+    QCOMPARE(repository->folderIdByName("Drafts"), folderId);
+    QVERIFY(QFileInfo::exists(m_vault->filePath("Drafts/a.md")));
+}
+
+// A lazily loaded vault has its bodies read for the index off the calling thread;
+// changes made meanwhile must survive the pass
+void TestMarkdownPromptRepository::searchIndexBuildsInBackground()
+{
+    writeFile("a.md", "Alpha", "About the harbour");
+    writeFile("Coding/b.md", "Beta", "About the lighthouse");
+    const std::unique_ptr<MarkdownPromptRepository> repository = openVault(true);
+    const QHash<QString, int> ids = idsByTitle(repository.get());
+
+    QSignalSpy ready(repository.get(), &PromptRepository::searchIndexReady);
+    QVERIFY(!repository->prepareSearchIndex());
+    std::unique_ptr<Prompt> beta(repository->getPromptById(ids.value("Beta")));
+    beta->setContent("About the windmill");
+    QVERIFY(repository->savePrompt(beta.get()));
+    QTRY_COMPARE(ready.count(), 1);
+
+    QVERIFY(repository->prepareSearchIndex());
+    for (const PromptRecord &record : repository->allPromptRecords()) {
+        QVERIFY(record.isContentLoaded());
+    }
+    const PromptSearchIndex index = repository->searchIndex();
+    const auto found = [&index, &repository](const QString &text) {
+        QList<int> result;
+        for (const PromptRecord &record : index.search(repository->parseSearchQuery(text))) {
+            result.append(record.id());
+        }
+        return result;
+    };
+    QCOMPARE(found("harbour"), QList<int>{ids.value("Alpha")});
+    QCOMPARE(found("windmill"), QList<int>{ids.value("Beta")});
+    QVERIFY(found("lighthouse").isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestMarkdownPromptRepository)
+#include "tst_markdownpromptrepository.moc"
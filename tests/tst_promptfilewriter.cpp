@@ -0,0 +1,149 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <memory>
+#include "repository/promptfilewriter.h"
+
+class TestPromptFileWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void coalescesSaves();
+    void renameFoldsIntoWaitingSave();
+    void savesStayBehindDirectoryRename();
+    void renameRefusesExistingDirectory();
+    void removeDirectoryAfterSaves();
+    void pendingCoversDirectoryContents();
+
+private:
+    QString path(const QString &relativePath) const { return m_dir->filePath(relativePath); }
+    static QByteArray read(const QString &filePath);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestPromptFileWriter::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+QByteArray TestPromptFileWriter::read(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Saves of one prompt queued faster than the disk takes them collapse into the last
+void TestPromptFileWriter::coalescesSaves()
+{
+    PromptFileWriter writer;
+    QSignalSpy written(&writer, &PromptFileWriter::fileWritten);
+    QSignalSpy idle(&writer, &PromptFileWriter::idle);
+
+    const int saves = 1000;
+    for (int i = 1; i <= saves; ++i) {
+        writer.write(1, path("a.md"), QString(), QByteArray::number(i));
+    }
+    writer.flush();
+
+    QCOMPARE(read(path("a.md")), QByteArray::number(saves));
+    QVERIFY(written.count() < saves);
+    QCOMPARE(written.constLast().at(0).toInt(), 1);
+    QTRY_VERIFY(idle.count() > 0);
+    QVERIFY(!writer.isBusy());
+}
+
+// The waiting save still expects the file at its old path, so a rename folded into
+// it has to move that one
+void TestPromptFileWriter::renameFoldsIntoWaitingSave()
+{
+    QFile original(path("a.md"));
+    QVERIFY(original.open(QIODevice::WriteOnly));
+    original.write("old");
+    original.close();
+
+    PromptFileWriter writer;
+    writer.write(1, path("a.md"), QString(), "first");
+    writer.write(1, path("b.md"), path("a.md"), "second");
+    writer.write(1, path("c.md"), path("b.md"), "third");
+    writer.flush();
+
+    QVERIFY(!QFile::exists(path("a.md")));
+    QVERIFY(!QFile::exists(path("b.md")));
+    QCOMPARE(read(path("c.md")), QByteArray("third"));
+}
+
+// Folded into the save ahead of the rename, the second save would create Final/ first
+// and the rename would fail on it
+void TestPromptFileWriter::savesStayBehindDirectoryRename()
+{
+    QVERIFY(QDir().mkpath(path("Drafts")));
+
+    PromptFileWriter writer;
+    QSignalSpy failed(&writer, &PromptFileWriter::writeFailed);
+    QSignalSpy moved(&writer, &PromptFileWriter::directoryChanged);
+    writer.write(1, path("Drafts/a.md"), QString(), "before");
+    writer.renameDirectory(path("Drafts"), path("Final"));
+    writer.write(1, path("Final/a.md"), QString(), "after");
+    writer.flush();
+
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(moved.constFirst().at(0).toString(), path("Final"));
+    QCOMPARE(moved.constFirst().at(1).toString(), path("Drafts"));
+    QVERIFY(!QFileInfo::exists(path("Drafts")));
+    QCOMPARE(read(path("Final/a.md")), QByteArray("after"));
+}
+
+void TestPromptFileWriter::renameRefusesExistingDirectory()
+{
+    QVERIFY(QDir().mkpath(path("Drafts")));
+    QVERIFY(QDir().mkpath(path("Final")));
+
+    PromptFileWriter writer;
+    QSignalSpy failed(&writer, &PromptFileWriter::writeFailed);
+    QSignalSpy moved(&writer, &PromptFileWriter::directoryChanged);
+    writer.renameDirectory(path("Drafts"), path("Final"));
+    writer.flush();
+
+    QCOMPARE(failed.count(), 1);
+    QCOMPARE(failed.constFirst().at(0).toInt(), -1);
+    QCOMPARE(moved.count(), 0);
+    QVERIFY(QFileInfo(path("Drafts")).isDir());
+}
+
+// A save queued before the removal must not bring the directory back
+void TestPromptFileWriter::removeDirectoryAfterSaves()
+{
+    PromptFileWriter writer;
+    writer.makeDirectory(path("Drafts"));
+    writer.write(1, path("Drafts/a.md"), QString(), "body");
+    writer.removeDirectory(path("Drafts"));
+    writer.flush();
+
+    QVERIFY(!QFileInfo::exists(path("Drafts")));
+}
+
+void TestPromptFileWriter::pendingCoversDirectoryContents()
+{
+    PromptFileWriter writer;
+    QVERIFY(!writer.isPending(path("Drafts")));
+    QVERIFY(!writer.isBusy());
+
+    writer.makeDirectory(path("Drafts"));
+    writer.renameDirectory(path("Drafts"), path("Final"));
+    // Until the rename is done, everything under either name is spoken for
+    QVERIFY(writer.isPending(path("Final/a.md")) || QFileInfo(path("Final")).isDir());
+    QVERIFY(!writer.isPending(path("Final2")));
+    QVERIFY(!writer.isPending(path("Fin")));
+    writer.flush();
+
+    QVERIFY(!writer.isBusy());
+    QVERIFY(!writer.isPending(path("Final")));
+    QVERIFY(QFileInfo(path("Final")).isDir());
+}
+
+QTEST_GUILESS_MAIN(TestPromptFileWriter)
+#include "tst_promptfilewriter.moc"
@@ -0,0 +1,195 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <cstring>
+#include "repository/promptindexsnapshot.h"
+
+class TestPromptIndexSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void roundTrip();
+    void empty();
+    void rejectsMissing();
+    void rejectsCorrupt_data();
+    void rejectsCorrupt();
+
+private:
+    static PromptIndexSnapshot::Contents contents();
+    QString writeSnapshot();
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+PromptIndexSnapshot::Contents TestPromptIndexSnapshot::contents()
+{
+    PromptIndexSnapshot::Contents contents;
+
+    PromptIndexSnapshot::Entry entry;
+    entry.relativePath = "Writing/reply.md";
+    entry.id = 7;
+    entry.size = 512;
+    entry.modifiedMs = 1767268800000;
+    entry.hash = 0x0123456789abcdefull;
+    entry.title = "Polite reply";
+    entry.createdAt = QDateTime::fromMSecsSinceEpoch(1767225600000);
+    entry.updatedAt = QDateTime::fromMSecsSinceEpoch(1767268800000);
+    contents.entries << entry;
+
+    entry.relativePath = "café.md";
+    entry.id = 3;
+    entry.size = 0;
+    entry.hash = 42;
+    entry.title = "Café menu ☕";
+    entry.createdAt = QDateTime();
+    entry.updatedAt = QDateTime();
+    contents.entries << entry;
+
+    entry.relativePath = "Coding/review.md";
+    entry.id = 12;
+    entry.size = 2048;
+    entry.title = QString();
+    contents.entries << entry;
+
+    contents.folders << PromptIndexSnapshot::FolderEntry{"Coding", 1}
+                     << PromptIndexSnapshot::FolderEntry{"Writing", 4};
+    contents.nextPromptId = 13;
+    contents.nextFolderId = 5;
+    return contents;
+}
+
+void TestPromptIndexSnapshot::init()
+{
+    QVERIFY(m_dir.isValid());
+    m_path = m_dir.filePath("index.bin");
+    QFile::remove(m_path);
+}
+
+QString TestPromptIndexSnapshot::writeSnapshot()
+{
+    if (!PromptIndexSnapshot::write(m_path, contents())) {
+        return QString();
+    }
+    return m_path;
+}
+
+void TestPromptIndexSnapshot::roundTrip()
+{
+    QVERIFY(!writeSnapshot().isEmpty());
+
+    PromptIndexSnapshot snapshot;
+    QVERIFY(snapshot.open(m_path));
+    QCOMPARE(snapshot.count(), 3);
+    QCOMPARE(snapshot.nextPromptId(), 13);
+    QCOMPARE(snapshot.nextFolderId(), 5);
+
+    // Sorted by path, which is what find() searches by
+    QCOMPARE(snapshot.entryAt(0).relativePath, QString("Coding/review.md"));
+    QCOMPARE(snapshot.entryAt(1).relativePath, QString("Writing/reply.md"));
+    QCOMPARE(snapshot.entryAt(2).relativePath, QString("café.md"));
+    QCOMPARE(snapshot.entryAt(3).id, -1);
+
+    for (const PromptIndexSnapshot::Entry &expected : contents().entries) {
+        PromptIndexSnapshot::Entry entry;
+        QVERIFY(snapshot.find(expected.relativePath, &entry));
+        QCOMPARE(entry.relativePath, expected.relativePath);
+        QCOMPARE(entry.id, expected.id);
+        QCOMPARE(entry.size, expected.size);
+        QCOMPARE(entry.modifiedMs, expected.modifiedMs);
+        QCOMPARE(entry.hash, expected.hash);
+        QCOMPARE(entry.title, expected.title);
+        QCOMPARE(entry.createdAt, expected.createdAt);
+        QCOMPARE(entry.updatedAt, expected.updatedAt);
+    }
+    QVERIFY(!snapshot.find(u"missing.md", nullptr));
+    QVERIFY(!snapshot.find(u"Coding", nullptr));
+
+    const QList<PromptIndexSnapshot::FolderEntry> folders = snapshot.folders();
+    QCOMPARE(folders.size(), 2);
+    QCOMPARE(folders.at(0).name, QString("Coding"));
+    QCOMPARE(folders.at(0).id, 1);
+    QCOMPARE(folders.at(1).name, QString("Writing"));
+    QCOMPARE(folders.at(1).id, 4);
+}
+
+void TestPromptIndexSnapshot::empty()
+{
+    QVERIFY(PromptIndexSnapshot::write(m_path, PromptIndexSnapshot::Contents()));
+
+    PromptIndexSnapshot snapshot;
+    QVERIFY(snapshot.open(m_path));
+    QCOMPARE(snapshot.count(), 0);
+    QVERIFY(snapshot.folders().isEmpty());
+    QVERIFY(!snapshot.find(u"a.md", nullptr));
+}
+
+void TestPromptIndexSnapshot::rejectsMissing()
+{
+    PromptIndexSnapshot snapshot;
+    QVERIFY(!snapshot.open(m_path));
+    QVERIFY(!snapshot.isOpen());
+    QCOMPARE(snapshot.count(), 0);
+    QCOMPARE(snapshot.nextPromptId(), 1);
+}
+
+void TestPromptIndexSnapshot::rejectsCorrupt_data()
+{
+    QTest::addColumn<QString>("damage");
+
+    QTest::newRow("empty file") << "empty";
+    QTest::newRow("short header") << "header";
+    QTest::newRow("truncated") << "truncate";
+    QTest::newRow("trailing bytes") << "append";
+    QTest::newRow("bad magic") << "magic";
+    QTest::newRow("other version") << "version";
+    QTest::newRow("wrong entry count") << "count";
+}
+
+// A damaged file must be refused as a whole, never half read
+void TestPromptIndexSnapshot::rejectsCorrupt()
+{
+    QFETCH(QString, damage);
+    QVERIFY(!writeSnapshot().isEmpty());
+
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    QVERIFY(data.size() > 32);
+
+    // Header: magic, version, entryCount, folderCount as quint32 from offset 0
+    auto patch = [&data](int offset, quint32 value) {
+        memcpy(data.data() + offset, &value, sizeof(value));
+    };
+    if (damage == "empty") {
+        data.clear();
+    } else if (damage == "header") {
+        data.truncate(16);
+    } else if (damage == "truncate") {
+        data.chop(2);
+    } else if (damage == "append") {
+        data.append(2, '\0');
+    } else if (damage == "magic") {
+        patch(0, 0xdeadbeef);
+    } else if (damage == "version") {
+        patch(4, 1);
+    } else if (damage == "count") {
+        quint32 count;
+        memcpy(&count, data.constData() + 8, sizeof(count));
+        patch(8, count + 1);
+    }
+
+    QVERIFY(file.resize(0));
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    PromptIndexSnapshot snapshot;
+    QVERIFY(!snapshot.open(m_path));
+    QVERIFY(!snapshot.isOpen());
+    QCOMPARE(snapshot.count(), 0);
+}
+
+QTEST_APPLESS_MAIN(TestPromptIndexSnapshot)
+#include "tst_promptindexsnapshot.moc"
@@ -0,0 +1,196 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QStandardPaths>
+#include <memory>
+#include "repository/markdownpromptrepository.h"
+#include "viewmodels/promptlistviewmodel.h"
+
+class TestPromptListViewModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void newPromptInsertsRow();
+    void editedPromptKeepsRow();
+    void deletedPromptRemovesRow();
+    void movedPromptLeavesFolder();
+    void searchFollowsEdits();
+
+private:
+    void writeFile(const QString &relativePath, const QString &title, const QString &body);
+    static QStringList titles(const PromptListViewModel &model);
+    int promptId(const QString &title) const;
+    void saveContent(const QString &title, const QString &content);
+
+    std::unique_ptr<QTemporaryDir> m_vault;
+    std::unique_ptr<MarkdownPromptRepository> m_repository;
+    std::unique_ptr<PromptListViewModel> m_model;
+};
+
+void TestPromptListViewModel::initTestCase()
+{
+    // Snapshots go to the app data location; keep them out of the real one
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestPromptListViewModel::init()
+{
+    m_vault = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_vault->isValid());
+    writeFile("a.md", "Alpha", "About the harbour");
+    writeFile("b.md", "Beta", "About the lighthouse");
+    writeFile("Coding/c.md", "Gamma", "About the compiler");
+
+    m_repository = std::make_unique<MarkdownPromptRepository>(m_vault->path(), 2);
+    m_model = std::make_unique<PromptListViewModel>(m_repository.get());
+    // Folders are listed first
+    QCOMPARE(titles(*m_model), (QStringList{"Gamma", "Alpha", "Beta"}));
+}
+
+void TestPromptListViewModel::cleanup()
+{
+    m_model.reset();
+    m_repository.reset();
+    QFile::remove(PromptIndexSnapshot::defaultLocation(m_vault->path()));
+    m_vault.reset();
+}
+
+void TestPromptListViewModel::writeFile(const QString &relativePath, const QString &title, const QString &body)
+{
+    const QString path = m_vault->filePath(relativePath);
+    QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QString("---\ntitle: %1\ncreatedAt: 2026-01-01T12:00:00\nupdatedAt: 2026-01-01T12:00:00\n---\n%2")
+                   .arg(title, body)
+                   .toUtf8());
+}
+
+QStringList TestPromptListViewModel::titles(const PromptListViewModel &model)
+{
+    QStringList result;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        result.append(model.data(model.index(row), PromptListViewModel::TitleRole).toString());
+    }
+    return result;
+}
+
+int TestPromptListViewModel::promptId(const QString &title) const
+{
+    for (const PromptRecord &record : m_repository->allPromptRecords()) {
+        if (record.title() == title) {
+            return record.id();
+        }
+    }
+    return -1;
+}
+
+void TestPromptListViewModel::saveContent(const QString &title, const QString &content)
+{
+    std::unique_ptr<Prompt> prompt(m_repository->getPromptById(promptId(title)));
+    QVERIFY(prompt);
+    prompt->setContent(content);
+    QVERIFY(m_repository->savePrompt(prompt.get()));
+}
+
+// Repository changes are row operations; a reset would lose the view's scroll
+// position and selection
+void TestPromptListViewModel::newPromptInsertsRow()
+{
+    QSignalSpy reset(m_model.get(), &QAbstractItemModel::modelReset);
+    QSignalSpy inserted(m_model.get(), &QAbstractItemModel::rowsInserted);
+
+    Prompt prompt;
+    prompt.setTitle("Delta");
+    prompt.setContent("About the river");
+    QVERIFY(m_repository->savePrompt(&prompt));
+
+    QTRY_COMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.constFirst().at(1).toInt(), 3);
+    QCOMPARE(titles(*m_model), (QStringList{"Gamma", "Alpha", "Beta", "Delta"}));
+    QCOMPARE(reset.count(), 0);
+}
+
+void TestPromptListViewModel::editedPromptKeepsRow()
+{
+    QSignalSpy reset(m_model.get(), &QAbstractItemModel::modelReset);
+    QSignalSpy changed(m_model.get(), &QAbstractItemModel::dataChanged);
+
+    std::unique_ptr<Prompt> prompt(m_repository->getPromptById(promptId("Beta")));
+    prompt->setTitle("Bravo");
+    QVERIFY(m_repository->savePrompt(prompt.get()));
+
+    QTRY_VERIFY(changed.count() > 0);
+    QCOMPARE(changed.constFirst().at(0).value<QModelIndex>().row(), 2);
+    QCOMPARE(titles(*m_model), (QStringList{"Gamma", "Alpha", "Bravo"}));
+    QCOMPARE(reset.count(), 0);
+}
+
+void TestPromptListViewModel::deletedPromptRemovesRow()
+{
+    QSignalSpy reset(m_model.get(), &QAbstractItemModel::modelReset);
+    QSignalSpy removed(m_model.get(), &QAbstractItemModel::rowsRemoved);
+
+    QVERIFY(m_repository->deletePrompt(promptId("Alpha")));
+
+    QTRY_COMPARE(removed.count(), 1);
+    QCOMPARE(removed.constFirst().at(1).toInt(), 1);
+    QCOMPARE(titles(*m_model), (QStringList{"Gamma", "Beta"}));
+    QCOMPARE(reset.count(), 0);
+}
+
+void TestPromptListViewModel::movedPromptLeavesFolder()
+{
+    const int codingId = m_repository->folderIdByName("Coding");
+    QVERIFY(codingId > 0);
+    m_model->setSelectedFolderId(codingId);
+    QCOMPARE(titles(*m_model), QStringList{"Gamma"});
+
+    QSignalSpy reset(m_model.get(), &QAbstractItemModel::modelReset);
+    QSignalSpy inserted(m_model.get(), &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(m_model.get(), &QAbstractItemModel::rowsRemoved);
+
+    std::unique_ptr<Prompt> alpha(m_repository->getPromptById(promptId("Alpha")));
+    alpha->setFolderId(codingId);
+    QVERIFY(m_repository->savePrompt(alpha.get()));
+    QTRY_COMPARE(inserted.count(), 1);
+    QCOMPARE(titles(*m_model), (QStringList{"Gamma", "Alpha"}));
+
+    std::unique_ptr<Prompt> gamma(m_repository->getPromptById(promptId("Gamma")));
+    gamma->setFolderId(-1);
+    QVERIFY(m_repository->savePrompt(gamma.get()));
+    QTRY_COMPARE(removed.count(), 1);
+    QCOMPARE(titles(*m_model), QStringList{"Alpha"});
+    QCOMPARE(reset.count(), 0);
+}
+
+// Changes are checked against the query as they come in: a prompt that starts to
+// match is added, one that stops is removed
+void TestPromptListViewModel::searchFollowsEdits()
+{
+    m_model->setSearchText("harbour");
+    QTRY_VERIFY(m_model->searchComplete() && titles(*m_model) == QStringList{"Alpha"});
+
+    QSignalSpy reset(m_model.get(), &QAbstractItemModel::modelReset);
+    QSignalSpy inserted(m_model.get(), &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(m_model.get(), &QAbstractItemModel::rowsRemoved);
+
+    saveContent("Beta", "A lighthouse by the harbour");
+    QTRY_COMPARE(inserted.count(), 1);
+    QCOMPARE(titles(*m_model), (QStringList{"Alpha", "Beta"}));
+
+    saveContent("Alpha", "About the sea");
+    QTRY_COMPARE(removed.count(), 1);
+    QCOMPARE(titles(*m_model), QStringList{"Beta"});
+
+    saveContent("Gamma", "About the compiler");
+    QTest::qWait(50);
+    QCOMPARE(titles(*m_model), QStringList{"Beta"});
+    QCOMPARE(reset.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestPromptListViewModel)
+#include "tst_promptlistviewmodel.moc"
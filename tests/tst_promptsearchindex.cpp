@@ -0,0 +1,259 @@
+#include <QtTest>
+#include <QThreadPool>
+#include "repository/promptsearchindex.h"
+
+class TestPromptSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void locateMapsFolding_data();
+    void locateMapsFolding();
+    void locateMergesTerms();
+    void locateRegex();
+    void locateRegexStopsAtDeadline();
+    void parallelMatchesSequential_data();
+    void parallelMatchesSequential();
+    void parallelStopsWhenCancelled();
+    void rankAddsInfixMatches();
+    void orderPointUpdates();
+
+private:
+    static QList<QPair<int, int>> spans(const QList<PromptSearchIndex::Span> &matches);
+    static QList<int> ids(const QList<PromptRecord> &records);
+    static PromptSearchIndex largeIndex();
+};
+
+QList<int> TestPromptSearchIndex::ids(const QList<PromptRecord> &records)
+{
+    QList<int> result;
+    for (const PromptRecord &record : records) {
+        result.append(record.id());
+    }
+    return result;
+}
+
+// Enough prompts that searching them goes parallel, listed newest first like the
+// SQL repository does
+PromptSearchIndex TestPromptSearchIndex::largeIndex()
+{
+    const QStringList words = {"summary", "report", "draft", "email", "review",
+                               "code", "bug", "plan", "menu", "reply", "Café"};
+    quint32 seed = 4242;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return int((seed >> 16) % quint32(bound));
+    };
+
+    const QDateTime created(QDate(2026, 1, 1), QTime(12, 0));
+    QList<PromptRecord> records;
+    QList<int> order;
+    for (int id = 1; id <= 20000; ++id) {
+        QStringList body;
+        for (int i = next(12) + 3; i > 0; --i) {
+            body << words.at(next(words.size()));
+        }
+        if (next(10) == 0) {
+            body << "{{topic}}";
+        }
+        records << PromptRecord(id, words.at(next(words.size())), body.join(' '), next(4),
+                                created, created.addSecs(id));
+        order.prepend(id);
+    }
+
+    PromptSearchIndex index;
+    index.update(records);
+    index.setOrder(order);
+    return index;
+}
+
+QList<QPair<int, int>> TestPromptSearchIndex::spans(const QList<PromptSearchIndex::Span> &matches)
+{
+    QList<QPair<int, int>> result;
+    for (const PromptSearchIndex::Span &span : matches) {
+        result.append(qMakePair(span.start, span.length));
+    }
+    return result;
+}
+
+void TestPromptSearchIndex::locateMapsFolding_data()
+{
+    QTest::addColumn<QString>("body");
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<int>("start");
+    QTest::addColumn<int>("length");
+
+    QTest::newRow("plain") << "A summary of it" << "summ" << 2 << 4;
+    QTest::newRow("case") << "A SUMMARY of it" << "summary" << 2 << 7;
+    QTest::newRow("precomposed accent") << "Un Café noir" << "cafe" << 3 << 4;
+    // The combining accent belongs to the matched e, so it is highlighted with it
+    QTest::newRow("combining accent") << QString(u"Un Cafe\u0301 noir") << "cafe" << 3 << 5;
+    QTest::newRow("accent before match") << QString(u"e\u0301te\u0301 long") << "long" << 6 << 4;
+    // One ligature folds to two letters; a match of either covers all of it
+    QTest::newRow("ligature whole") << QString(u"a \uFB01le") << "file" << 2 << 3;
+    QTest::newRow("ligature half") << QString(u"a \uFB01le") << "fi" << 2 << 1;
+}
+
+// Terms are found in folded text but the spans have to point into the original
+void TestPromptSearchIndex::locateMapsFolding()
+{
+    QFETCH(QString, body);
+    QFETCH(QString, query);
+    QFETCH(int, start);
+    QFETCH(int, length);
+
+    const QList<PromptSearchIndex::Span> matches = PromptSearchIndex::locate(SearchQuery::parse(query), body, 16);
+    QCOMPARE(spans(matches), (QList<QPair<int, int>>{qMakePair(start, length)}));
+}
+
+void TestPromptSearchIndex::locateMergesTerms()
+{
+    const QString body = "summary, then a summary";
+    QCOMPARE(spans(PromptSearchIndex::locate(SearchQuery::parse("summ mary"), body, 16)),
+             (QList<QPair<int, int>>{qMakePair(0, 7), qMakePair(16, 7)}));
+    QCOMPARE(spans(PromptSearchIndex::locate(SearchQuery::parse("summ"), body, 1)),
+             (QList<QPair<int, int>>{qMakePair(0, 4)}));
+    QVERIFY(PromptSearchIndex::locate(SearchQuery::parse("draft"), body, 16).isEmpty());
+    QVERIFY(PromptSearchIndex::locate(SearchQuery::parse("summ"), QString(), 16).isEmpty());
+}
+
+void TestPromptSearchIndex::locateRegex()
+{
+    bool matched = false;
+    const QRegularExpression words("\\bt\\w+");
+    QCOMPARE(spans(PromptSearchIndex::locate(words, "one two three", 16, &matched)),
+             (QList<QPair<int, int>>{qMakePair(4, 3), qMakePair(8, 5)}));
+    QVERIFY(matched);
+
+    QCOMPARE(PromptSearchIndex::locate(QRegularExpression("a"), "aaaa", 2).size(), 2);
+
+    // An empty match selects the prompt without anything to highlight
+    QVERIFY(PromptSearchIndex::locate(QRegularExpression("^"), "text", 16, &matched).isEmpty());
+    QVERIFY(matched);
+
+    PromptSearchIndex::locate(words, "none", 16, &matched);
+    QVERIFY(!matched);
+}
+
+void TestPromptSearchIndex::locateRegexStopsAtDeadline()
+{
+    bool matched = true;
+    const QList<PromptSearchIndex::Span> matches =
+        PromptSearchIndex::locate(QRegularExpression("a"), "aaaa", 16, &matched, QDeadlineTimer(0));
+    QVERIFY(matches.isEmpty());
+    QVERIFY(!matched);
+}
+
+void TestPromptSearchIndex::parallelMatchesSequential_data()
+{
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("everything") << "";
+    QTest::newRow("common word") << "report";
+    QTest::newRow("two words") << "draft bug";
+    QTest::newRow("accents") << "cafe";
+    QTest::newRow("short prefix") << "re";
+    QTest::newRow("negation") << "review -menu";
+    QTest::newRow("placeholders") << "summ has:placeholders";
+    QTest::newRow("folder") << "plan folder:2";
+    QTest::newRow("nothing") << "zzz";
+}
+
+// Chunks verified on the pool have to come back as the same matches, in the same
+// order and in batches that start small, as a scan on the calling thread
+void TestPromptSearchIndex::parallelMatchesSequential()
+{
+    QFETCH(QString, query);
+    const PromptSearchIndex index = largeIndex();
+    const SearchQuery parsed = SearchQuery::parse(query, [](const QString &name) { return name.toInt(); });
+
+    QList<int> sequential;
+    index.search(parsed, [&sequential](const QList<PromptRecord> &batch) { sequential += ids(batch); });
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QList<int> parallel;
+    QList<int> batchSizes;
+    index.search(parsed, [&](const QList<PromptRecord> &batch) {
+        parallel += ids(batch);
+        batchSizes.append(batch.size());
+    }, PromptSearchIndex::CancelCheck(), &pool);
+    QCOMPARE(parallel, sequential);
+    if (!batchSizes.isEmpty()) {
+        QVERIFY(batchSizes.constFirst() <= 32);
+    }
+
+    // Refining over the matches of everything is the same search again
+    QList<int> refined;
+    index.refine(parsed, ids(index.search(SearchQuery::parse(QString()))), [&refined](const QList<PromptRecord> &batch) {
+        refined += ids(batch);
+    }, PromptSearchIndex::CancelCheck(), &pool);
+    QCOMPARE(refined, sequential);
+}
+
+void TestPromptSearchIndex::parallelStopsWhenCancelled()
+{
+    const PromptSearchIndex index = largeIndex();
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+
+    int checks = 0;
+    QList<int> found;
+    index.search(SearchQuery::parse(QString()), [&found](const QList<PromptRecord> &batch) {
+        found += ids(batch);
+    }, [&checks]() { return ++checks > 1; }, &pool);
+    QVERIFY(!found.isEmpty());
+    QVERIFY(found.size() < index.size());
+    QCOMPARE(found, ids(index.search(SearchQuery::parse(QString()))).mid(0, found.size()));
+}
+
+// BM25 can't see "script" inside "javascript"; the plan can, so those still show up,
+// after everything that was actually ranked
+void TestPromptSearchIndex::rankAddsInfixMatches()
+{
+    const QDateTime time(QDate(2026, 1, 1), QTime(12, 0));
+    PromptSearchIndex index;
+    index.update({PromptRecord(1, "JavaScript tips", "Closures and promises", 1, time, time),
+                  PromptRecord(2, "Shell script", "A bash script that backs up a folder", 1, time, time),
+                  PromptRecord(3, "Python", "Scripting a release", 1, time, time),
+                  PromptRecord(4, "Menu", "Dinner for four", 1, time, time),
+                  PromptRecord(5, "Notes", "Describe this manuscript", 1, time, time)});
+    index.setOrder({5, 4, 3, 2, 1});
+
+    const QList<int> ranked = ids(index.rank(SearchQuery::parse("script"), 10));
+    QCOMPARE(ranked.size(), 4);
+    QCOMPARE(QSet<int>(ranked.cbegin(), ranked.cbegin() + 2), (QSet<int>{2, 3}));
+    QCOMPARE(ranked.mid(2), (QList<int>{5, 1}));
+
+    QCOMPARE(ids(index.rank(SearchQuery::parse("script"), 3)).mid(2), QList<int>{5});
+    QCOMPARE(ids(index.rank(SearchQuery::parse("script"), 2)).size(), 2);
+    QVERIFY(index.rank(SearchQuery::parse("zzz"), 10).isEmpty());
+}
+
+// Prepending hands out positions below the ones already there, so candidates still
+// sort into listing order after any mix of point updates
+void TestPromptSearchIndex::orderPointUpdates()
+{
+    const QDateTime time(QDate(2026, 1, 1), QTime(12, 0));
+    PromptSearchIndex index;
+    QList<PromptRecord> records;
+    for (int id = 1; id <= 5; ++id) {
+        records << PromptRecord(id, QString("Note %1").arg(id), "A summary", 1, time, time);
+    }
+    index.update(records);
+    index.setOrder({2, 3});
+    index.appendToOrder(4);
+    index.prependToOrder(1);
+    index.prependToOrder(5);
+    index.removeFromOrder(3);
+    index.prependToOrder(3);
+    index.prependToOrder(3);
+
+    QCOMPARE(ids(index.search(SearchQuery::parse("summ"))), (QList<int>{3, 5, 1, 2, 4}));
+    QCOMPARE(ids(index.search(SearchQuery::parse(QString()))), (QList<int>{3, 5, 1, 2, 4}));
+    QCOMPARE(index.record(4).title(), QString("Note 4"));
+    QVERIFY(!index.record(6).isValid());
+}
+
+QTEST_APPLESS_MAIN(TestPromptSearchIndex)
+#include "tst_promptsearchindex.moc"
@@ -0,0 +1,154 @@
+#include <QtTest>
+#include "utils/searchquery.h"
+#include "repository/promptsearchindex.h"
+
+class TestSearchQuery : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void refines_data();
+    void refines();
+    void refinesFolder();
+    void refineMatchesSearch_data();
+    void refineMatchesSearch();
+
+private:
+    static int folderLookup(const QString &name);
+    static PromptSearchIndex buildIndex();
+    static QList<int> ids(const QList<PromptRecord> &records);
+};
+
+int TestSearchQuery::folderLookup(const QString &name)
+{
+    if (name.compare(QLatin1String("coding"), Qt::CaseInsensitive) == 0) {
+        return 1;
+    }
+    if (name.compare(QLatin1String("writing"), Qt::CaseInsensitive) == 0) {
+        return 2;
+    }
+    return -1;
+}
+
+PromptSearchIndex TestSearchQuery::buildIndex()
+{
+    const QDateTime early(QDate(2026, 1, 1), QTime(12, 0));
+    const QDateTime late(QDate(2026, 6, 1), QTime(12, 0));
+
+    QList<PromptRecord> records;
+    records << PromptRecord(1, "Summary report", "Summarize {{topic}} in three bullets", 1, early, early)
+            << PromptRecord(2, "Summer plans", "A draft memo about the trip", 2, early, late)
+            << PromptRecord(3, "Code review", "Review this diff for bugs", 1, late, late)
+            << PromptRecord(4, "Café menu", "Write a menu for a small cafe", -1, early, late)
+            << PromptRecord(5, "Draft reply", "Reply to the summary email politely", 2, late, late)
+            << PromptRecord(6, "Refactor", "Summarize what {{file}} does, then refactor it", 1, early, early);
+
+    PromptSearchIndex index;
+    index.update(records);
+    index.setOrder({6, 5, 4, 3, 2, 1});
+    return index;
+}
+
+QList<int> TestSearchQuery::ids(const QList<PromptRecord> &records)
+{
+    QList<int> result;
+    for (const PromptRecord &record : records) {
+        result.append(record.id());
+    }
+    return result;
+}
+
+void TestSearchQuery::refines_data()
+{
+    QTest::addColumn<QString>("previous");
+    QTest::addColumn<QString>("next");
+    QTest::addColumn<bool>("refines");
+
+    QTest::newRow("same text") << "summ" << "summ" << true;
+    QTest::newRow("longer word") << "summ" << "summar" << true;
+    QTest::newRow("added word") << "summ" << "summ report" << true;
+    QTest::newRow("backspace") << "summar" << "summa" << false;
+    QTest::newRow("replaced word") << "summ" << "draft" << false;
+    QTest::newRow("case and accents") << "cafe" << "CAFÉS" << true;
+    QTest::newRow("spacing and order") << "memo draft" << "draft   memo" << true;
+    QTest::newRow("title narrows text") << "summ" << "title:summary" << true;
+    QTest::newRow("text widens title") << "title:summ" << "summary" << false;
+    QTest::newRow("longer negation") << "-dra" << "-draft" << false;
+    QTest::newRow("shorter negation") << "-draft" << "-dra" << false;
+    QTest::newRow("negation kept") << "-draft" << "-draft memo" << true;
+    QTest::newRow("negation added") << "memo" << "memo -draft" << true;
+    QTest::newRow("filter added") << "memo" << "memo has:placeholders" << true;
+    QTest::newRow("filter dropped") << "memo has:placeholders" << "memo" << false;
+    QTest::newRow("same date") << "updated:>2026-01-01" << "updated:>2026-01-01 memo" << true;
+    QTest::newRow("changed date") << "updated:>2026-01-01" << "updated:>2026-02-01" << false;
+    QTest::newRow("changed comparison") << "updated:>2026-01-01" << "updated:>=2026-01-01" << false;
+    QTest::newRow("from empty") << "" << "memo" << true;
+    QTest::newRow("to empty") << "memo" << "" << false;
+}
+
+void TestSearchQuery::refines()
+{
+    QFETCH(QString, previous);
+    QFETCH(QString, next);
+    QFETCH(bool, refines);
+
+    const SearchQuery before = SearchQuery::parse(previous, folderLookup);
+    const SearchQuery after = SearchQuery::parse(next, folderLookup);
+    QCOMPARE(after.refines(before), refines);
+}
+
+void TestSearchQuery::refinesFolder()
+{
+    const SearchQuery coding = SearchQuery::parse("folder:coding", folderLookup);
+    const SearchQuery writing = SearchQuery::parse("folder:writing", folderLookup);
+    QVERIFY(SearchQuery::parse("folder:Coding review", folderLookup).refines(coding));
+    QVERIFY(!writing.refines(coding));
+
+    // The folder picked in the UI is a clause like any other
+    SearchQuery all = SearchQuery::parse("summ", folderLookup);
+    SearchQuery inCoding = SearchQuery::parse("summ", folderLookup);
+    inCoding.restrictToFolder(1);
+    SearchQuery inWriting = SearchQuery::parse("summary", folderLookup);
+    inWriting.restrictToFolder(2);
+    QVERIFY(inCoding.refines(all));
+    QVERIFY(!all.refines(inCoding));
+    QVERIFY(!inWriting.refines(inCoding));
+}
+
+void TestSearchQuery::refineMatchesSearch_data()
+{
+    QTest::addColumn<QString>("previous");
+    QTest::addColumn<QString>("next");
+
+    QTest::newRow("typing") << "su" << "summ";
+    QTest::newRow("added word") << "summ" << "summ report";
+    QTest::newRow("title") << "summ" << "title:summ";
+    QTest::newRow("negation") << "summ" << "summ -draft";
+    QTest::newRow("placeholders") << "summ" << "summ has:placeholders";
+    QTest::newRow("folder") << "re" << "re folder:coding";
+    QTest::newRow("date") << "" << "updated:>2026-03-01";
+    QTest::newRow("accents") << "caf" << "CAFÉ";
+    QTest::newRow("no matches") << "summ" << "summzz";
+}
+
+// Narrowing the previous matches has to find exactly what a full search does
+void TestSearchQuery::refineMatchesSearch()
+{
+    QFETCH(QString, previous);
+    QFETCH(QString, next);
+
+    const PromptSearchIndex index = buildIndex();
+    const SearchQuery before = SearchQuery::parse(previous, folderLookup);
+    const SearchQuery after = SearchQuery::parse(next, folderLookup);
+    QVERIFY(after.refines(before));
+
+    const QList<int> previousIds = ids(index.search(before));
+    QList<int> refined;
+    index.refine(after, previousIds, [&refined](const QList<PromptRecord> &batch) {
+        refined += ids(batch);
+    });
+    QCOMPARE(refined, ids(index.search(after)));
+}
+
+QTEST_APPLESS_MAIN(TestSearchQuery)
+#include "tst_searchquery.moc"
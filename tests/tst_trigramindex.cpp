@@ -0,0 +1,142 @@
+#include <QtTest>
+#include "utils/trigramindex.h"
+
+class TestTrigramIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void candidatesCoverMatches_data();
+    void candidatesCoverMatches();
+    void batchMatchesInsert();
+    void shortQueryNarrowsNothing();
+    void removeDropsDocument();
+
+private:
+    static QList<int> matching(const QHash<int, QString> &documents, const QString &query);
+
+    QHash<int, QString> m_documents;
+    TrigramIndex m_index;
+};
+
+QList<int> TestTrigramIndex::matching(const QHash<int, QString> &documents, const QString &query)
+{
+    QList<int> result;
+    for (auto it = documents.cbegin(); it != documents.cend(); ++it) {
+        if (it.value().contains(query)) {
+            result.append(it.key());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// A small alphabet, so most trigrams are shared and candidates outnumber matches;
+// the CJK and Cyrillic letters go through the hashed and the exact key space
+void TestTrigramIndex::initTestCase()
+{
+    const QString alphabet = QString(u"abcdя日本");
+    quint32 seed = 777;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return int((seed >> 16) % quint32(bound));
+    };
+
+    for (int docId = 1; docId <= 400; ++docId) {
+        QString text;
+        for (int i = next(40) + 3; i > 0; --i) {
+            text.append(alphabet.at(next(alphabet.size())));
+        }
+        m_documents.insert(docId, text);
+        m_index.insert(docId, TrigramIndex::trigrams(text));
+    }
+}
+
+void TestTrigramIndex::candidatesCoverMatches_data()
+{
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("three") << "abc";
+    QTest::newRow("repeated") << "aaaa";
+    QTest::newRow("longer") << "abcdab";
+    QTest::newRow("cyrillic") << QString(u"aяb");
+    QTest::newRow("cjk") << QString(u"日本日");
+    QTest::newRow("mixed") << QString(u"d日a");
+    QTest::newRow("absent letter") << "abz";
+}
+
+// Candidates may include false positives but never miss a document containing the
+// query, and come back sorted and unique
+void TestTrigramIndex::candidatesCoverMatches()
+{
+    QFETCH(QString, query);
+
+    QList<int> candidates;
+    QVERIFY(m_index.candidates(query, &candidates));
+    QVERIFY(std::is_sorted(candidates.cbegin(), candidates.cend()));
+    QVERIFY(std::adjacent_find(candidates.cbegin(), candidates.cend()) == candidates.cend());
+
+    for (int docId : matching(m_documents, query)) {
+        QVERIFY2(std::binary_search(candidates.cbegin(), candidates.cend(), docId),
+                 qPrintable(QString("document %1 missing").arg(docId)));
+    }
+    if (query == "abz") {
+        QVERIFY(candidates.isEmpty());
+    }
+}
+
+// Indexing a vault in one batch, in any ID order, has to end up with the same
+// sorted postings as inserting documents one at a time
+void TestTrigramIndex::batchMatchesInsert()
+{
+    QList<int> docIds = m_documents.keys();
+    std::sort(docIds.begin(), docIds.end(), std::greater<int>());
+    QList<QList<TrigramIndex::Trigram>> trigrams;
+    for (int docId : std::as_const(docIds)) {
+        trigrams.append(TrigramIndex::trigrams(m_documents.value(docId)));
+    }
+
+    TrigramIndex batch;
+    batch.insertBatch(docIds, trigrams);
+    QCOMPARE(batch.documentCount(), m_index.documentCount());
+
+    for (const QString &query : {QString("abc"), QString("dda"), QString(u"я日本"), QString("cab")}) {
+        QList<int> expected;
+        QList<int> actual;
+        QVERIFY(m_index.candidates(query, &expected));
+        QVERIFY(batch.candidates(query, &actual));
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestTrigramIndex::shortQueryNarrowsNothing()
+{
+    QList<int> result{42};
+    QVERIFY(!m_index.candidates(u"ab", &result));
+    QVERIFY(!m_index.candidates(u"", &result));
+    QCOMPARE(result, QList<int>{42});
+    QVERIFY(TrigramIndex::trigrams(u"ab").isEmpty());
+}
+
+void TestTrigramIndex::removeDropsDocument()
+{
+    TrigramIndex index;
+    index.insert(1, TrigramIndex::trigrams(u"summary"));
+    index.insert(2, TrigramIndex::trigrams(u"summer"));
+
+    QList<int> result;
+    QVERIFY(index.candidates(u"umm", &result));
+    QCOMPARE(result, (QList<int>{1, 2}));
+
+    index.remove(1, u"summary");
+    QVERIFY(!index.contains(1));
+    QCOMPARE(index.documentCount(), 1);
+    QVERIFY(index.candidates(u"umm", &result));
+    QCOMPARE(result, QList<int>{2});
+    QVERIFY(index.candidates(u"mary", &result));
+    QVERIFY(result.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(TestTrigramIndex)
+#include "tst_trigramindex.moc"
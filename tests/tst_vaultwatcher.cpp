@@ -0,0 +1,138 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <memory>
+#include "repository/vaultwatcher.h"
+
+class TestVaultWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void reportsNewFile();
+    void reportsEditInPlace();
+    void coalescesBurst();
+    void ignoresOtherFiles();
+    void followsAddedAndRemovedDirectories();
+
+private:
+    QString path(const QString &relativePath) const
+    {
+        return QDir::cleanPath(QDir(m_dir->path()).absoluteFilePath(relativePath));
+    }
+    void writeFile(const QString &relativePath, const QByteArray &data,
+                   QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate);
+    static QSet<QString> reported(const QSignalSpy &spy);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    std::unique_ptr<VaultWatcher> m_watcher;
+};
+
+void TestVaultWatcher::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_watcher = std::make_unique<VaultWatcher>();
+    m_watcher->setDebounce(20, 500);
+}
+
+void TestVaultWatcher::cleanup()
+{
+    m_watcher.reset();
+    m_dir.reset();
+}
+
+void TestVaultWatcher::writeFile(const QString &relativePath, const QByteArray &data, QIODevice::OpenMode mode)
+{
+    QFile file(path(relativePath));
+    QVERIFY(file.open(mode));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+QSet<QString> TestVaultWatcher::reported(const QSignalSpy &spy)
+{
+    QSet<QString> directories;
+    for (const QList<QVariant> &arguments : spy) {
+        for (const QString &directory : arguments.at(0).toStringList()) {
+            directories.insert(directory);
+        }
+    }
+    return directories;
+}
+
+void TestVaultWatcher::reportsNewFile()
+{
+    QSignalSpy changed(m_watcher.get(), &VaultWatcher::directoriesChanged);
+    m_watcher->setDirectories({m_dir->path()});
+
+    writeFile("a.md", "hello");
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(reported(changed), QSet<QString>{path(".")});
+}
+
+// Rewriting a file in place changes nothing in its directory listing; the watch on
+// the directory still has to see it
+void TestVaultWatcher::reportsEditInPlace()
+{
+    writeFile("a.md", "hello");
+    QSignalSpy changed(m_watcher.get(), &VaultWatcher::directoriesChanged);
+    m_watcher->setDirectories({m_dir->path()});
+
+    writeFile("a.md", " again", QIODevice::WriteOnly | QIODevice::Append);
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(reported(changed), QSet<QString>{path(".")});
+}
+
+// A sync tool dropping many files at once is one rescan, not one per file
+void TestVaultWatcher::coalescesBurst()
+{
+    QVERIFY(QDir().mkpath(path("Coding")));
+    QSignalSpy changed(m_watcher.get(), &VaultWatcher::directoriesChanged);
+    m_watcher->setDirectories({m_dir->path(), path("Coding")});
+
+    for (int i = 0; i < 50; ++i) {
+        writeFile(QString("%1.md").arg(i), "body");
+        writeFile(QString("Coding/%1.md").arg(i), "body");
+    }
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(reported(changed), (QSet<QString>{path("."), path("Coding")}));
+    QTest::qWait(100);
+    QCOMPARE(changed.count(), 1);
+}
+
+// Editor swap files and QSaveFile temporaries come and go next to prompts
+void TestVaultWatcher::ignoresOtherFiles()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("Only the inotify backend filters by file name");
+#endif
+    QSignalSpy changed(m_watcher.get(), &VaultWatcher::directoriesChanged);
+    m_watcher->setDirectories({m_dir->path()});
+
+    writeFile("notes.txt", "not a prompt");
+    writeFile(".a.md.swp", "swap");
+    QTest::qWait(100);
+    QCOMPARE(changed.count(), 0);
+}
+
+void TestVaultWatcher::followsAddedAndRemovedDirectories()
+{
+    QVERIFY(QDir().mkpath(path("Coding")));
+    QSignalSpy changed(m_watcher.get(), &VaultWatcher::directoriesChanged);
+    m_watcher->setDirectories({m_dir->path()});
+
+    m_watcher->addDirectory(path("Coding"));
+    writeFile("Coding/a.md", "body");
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(reported(changed), QSet<QString>{path("Coding")});
+
+    changed.clear();
+    m_watcher->removeDirectory(path("Coding"));
+    writeFile("Coding/b.md", "body");
+    QTest::qWait(100);
+    QCOMPARE(changed.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestVaultWatcher)
+#include "tst_vaultwatcher.moc"